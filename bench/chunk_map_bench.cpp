@@ -0,0 +1,173 @@
+// Chunk container microbenchmark: ChunkMap/ChunkSet against the std::map/std::set they replaced.
+// Measures the access patterns the renderer has: neighbour lookups while scheduling and meshing,
+// full iteration for the draw lists, and ring churn as the camera crosses chunk borders.
+//
+//   run/chunk_map_bench [--view-distance N] [--iterations N]
+#include "chunk.h"
+#include "chunk_map.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+using ChunkKey = std::pair<int, int>;
+
+struct BenchOptions {
+    int viewDistance = 32;
+    int iterations = 20;
+};
+
+void printUsage() {
+    std::cout << "usage: chunk_map_bench [--view-distance N] [--iterations N]" << std::endl;
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--view-distance") opts.viewDistance = std::atoi(value);
+        else if (arg == "--iterations") opts.iterations = std::atoi(value);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (opts.viewDistance < 1 || opts.iterations < 1) {
+        std::cerr << "Invalid view distance or iteration count" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Best-of-N wall time of `body`, in nanoseconds per `operations`
+template <typename Body>
+double bestNsPerOp(int iterations, long long operations, Body&& body) {
+    double best = 1e30;
+    for (int iter = 0; iter < iterations; ++iter) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds);
+    }
+    return best * 1e9 / static_cast<double>(operations);
+}
+
+// Keeps results alive so the optimiser can't drop the loops
+volatile long long sink = 0;
+
+void report(const char* name, double stdNs, double flatNs) {
+    std::cout << "  " << name << ": std " << stdNs << " ns, flat " << flatNs << " ns ("
+              << stdNs / flatNs << "x)" << std::endl;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage();
+        return 1;
+    }
+
+    // Same shape as the renderer: visible ring plus a one-chunk data apron
+    const int radius = opts.viewDistance + 1;
+    std::vector<ChunkKey> keys;
+    for (int dx = -radius; dx <= radius; ++dx) {
+        for (int dz = -radius; dz <= radius; ++dz) {
+            keys.emplace_back(dx, dz);
+        }
+    }
+    const long long n = static_cast<long long>(keys.size());
+
+    // Empty volume: only the shared pointer is copied around, as in the renderer's maps
+    ChunkBlocks blocks = std::make_shared<const ChunkVolume>();
+    std::map<ChunkKey, ChunkBlocks> stdMap;
+    ChunkMap<ChunkBlocks> flatMap;
+    std::set<ChunkKey> stdSet;
+    ChunkSet flatSet;
+    for (const ChunkKey& key : keys) {
+        stdMap.emplace(key, blocks);
+        flatMap.emplace(key, blocks);
+        stdSet.insert(key);
+        flatSet.insert(key);
+    }
+
+    std::cout << "chunk_map_bench: " << n << " chunks (view distance " << opts.viewDistance << "), "
+              << opts.iterations << " iterations, best ns per operation" << std::endl;
+
+    // Five lookups per chunk (centre plus four neighbours), like scheduleChunkJobs' meshing check
+    auto neighbourLookups = [&](auto& map) {
+        long long found = 0;
+        for (const ChunkKey& key : keys) {
+            found += map.find(key) != map.end();
+            found += map.find(ChunkKey(key.first - 1, key.second)) != map.end();
+            found += map.find(ChunkKey(key.first + 1, key.second)) != map.end();
+            found += map.find(ChunkKey(key.first, key.second - 1)) != map.end();
+            found += map.find(ChunkKey(key.first, key.second + 1)) != map.end();
+        }
+        sink = sink + found;
+    };
+    report("neighbour lookup", bestNsPerOp(opts.iterations, n * 5, [&] { neighbourLookups(stdMap); }),
+           bestNsPerOp(opts.iterations, n * 5, [&] { neighbourLookups(flatMap); }));
+
+    auto iterate = [&](auto& map) {
+        long long total = 0;
+        for (const auto& entry : map) {
+            total += static_cast<long long>(entry.second->size()) + entry.first.first;
+        }
+        sink = sink + total;
+    };
+    report("map iteration", bestNsPerOp(opts.iterations, n, [&] { iterate(stdMap); }),
+           bestNsPerOp(opts.iterations, n, [&] { iterate(flatMap); }));
+
+    // Draw-list pattern: walk the visible set and look each chunk up in the mesh map
+    auto drawList = [&](auto& set, auto& map) {
+        long long total = 0;
+        for (const ChunkKey& key : set) {
+            auto it = map.find(key);
+            if (it != map.end()) total += static_cast<long long>(it->second->size());
+        }
+        sink = sink + total;
+    };
+    report("set walk + map lookup", bestNsPerOp(opts.iterations, n, [&] { drawList(stdSet, stdMap); }),
+           bestNsPerOp(opts.iterations, n, [&] { drawList(flatSet, flatMap); }));
+
+    // Camera moves one chunk along +X: evict the trailing column, insert the leading one, and back
+    const int side = 2 * radius + 1;
+    auto ringChurn = [&](auto& map) {
+        for (int step = 0; step < 2 * side; ++step) {
+            const int shift = step < side ? step : 2 * side - 1 - step;
+            const int forward = step < side;
+            for (int dz = -radius; dz <= radius; ++dz) {
+                if (forward) {
+                    map.erase(ChunkKey(-radius + shift, dz));
+                    map.emplace(ChunkKey(radius + shift + 1, dz), blocks);
+                } else {
+                    map.erase(ChunkKey(radius + shift + 1, dz));
+                    map.emplace(ChunkKey(-radius + shift, dz), blocks);
+                }
+            }
+        }
+    };
+    report("ring erase + insert", bestNsPerOp(opts.iterations, 4LL * side * side, [&] { ringChurn(stdMap); }),
+           bestNsPerOp(opts.iterations, 4LL * side * side, [&] { ringChurn(flatMap); }));
+
+    if (stdMap.size() != flatMap.size()) {
+        std::cerr << "Container sizes diverged: " << stdMap.size() << " vs " << flatMap.size() << std::endl;
+        return 1;
+    }
+    return 0;
+}
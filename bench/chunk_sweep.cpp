@@ -0,0 +1,201 @@
+// Chunk size sweep: the same square of terrain cut into chunks of each size, reporting generation and
+// meshing time, block and mesh memory, and what drawing it would cost (one draw record per non-empty mesh,
+// i.e. draw calls per pass on the per-chunk path or commands in the indirect buffer).
+// GL-free; for measured GPU cost run the headless app with --chunk-size/--view-distance.
+//
+//   run/chunk_sweep [--sizes 4,8,16,32] [--chunk-height N] [--view-blocks N] [--iterations N]
+//                   [--meshing naive|greedy|binary] [--chunk-storage sections|runs]
+#include "chunk.h"
+#include "heightfield.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+struct SweepOptions {
+    std::vector<int> sizes{4, 8, 16, 32};
+    int chunkHeight = 32;
+    // View radius in blocks; each size gets viewBlocks / size chunks so the area is the same
+    int viewBlocks = 128;
+    int iterations = 3;
+    MeshingMode meshing = MeshingMode::Naive;
+    ChunkStorage storage = ChunkStorage::Sections;
+};
+
+// Same rounding as VertexArena, so the mesh memory matches what the renderer reserves
+constexpr size_t GRANULE_VERTICES = 64;
+// sizeof(DrawElementsIndirectCommand)
+constexpr size_t INDIRECT_COMMAND_BYTES = 20;
+
+void printUsage() {
+    std::cout << "usage: chunk_sweep [--sizes 4,8,16,32] [--chunk-height N] [--view-blocks N] [--iterations N]\n"
+              << "                   [--meshing naive|greedy|binary] [--chunk-storage sections|runs]" << std::endl;
+}
+
+bool parseSizes(const char* value, std::vector<int>& sizes) {
+    sizes.clear();
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int size = std::atoi(item.c_str());
+        if (size < 1) return false;
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
+
+bool parseArgs(int argc, char** argv, SweepOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--sizes") {
+            if (!parseSizes(value, opts.sizes)) {
+                std::cerr << "Invalid size list " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--chunk-height") opts.chunkHeight = std::atoi(value);
+        else if (arg == "--view-blocks") opts.viewBlocks = std::atoi(value);
+        else if (arg == "--iterations") opts.iterations = std::atoi(value);
+        else if (arg == "--meshing") {
+            if (!parseMeshingMode(value, opts.meshing)) {
+                std::cerr << "Unknown meshing mode " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--chunk-storage") {
+            if (!parseChunkStorage(value, opts.storage)) {
+                std::cerr << "Unknown chunk storage " << value << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (opts.chunkHeight <= ChunkDimensions{}.waterLevel || opts.viewBlocks < 1 || opts.iterations < 1) {
+        std::cerr << "Invalid chunk height, view radius or iteration count" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+struct SweepResult {
+    int spanBlocks = 0; // meshed square edge; rounding to whole chunks makes it grow a little with the size
+    size_t chunks = 0;
+    double generateMs = 0.0;
+    double meshMs = 0.0;
+    size_t blockBytes = 0;
+    size_t meshBytes = 0;
+    size_t vertices = 0;
+    size_t drawRecords = 0;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Best of `iterations` runs for generation and meshing; the memory and draw figures are the same every run
+SweepResult runSize(const SweepOptions& opts, int size) {
+    ChunkDimensions dims;
+    dims.size = size;
+    dims.height = opts.chunkHeight;
+    const int viewDistance = std::max(1, opts.viewBlocks / size);
+    // One ring past the view so every meshed chunk has its four neighbours, as in the renderer
+    const int genRadius = viewDistance + 1;
+    const int genSide = 2 * genRadius + 1;
+
+    SweepResult result;
+    result.spanBlocks = (2 * viewDistance + 1) * size;
+    result.generateMs = 1e30;
+    result.meshMs = 1e30;
+    std::vector<ChunkBlocks> grid(static_cast<size_t>(genSide) * genSide);
+    std::vector<PackedChunkVertex> vertices;
+    for (int iter = 0; iter < opts.iterations; ++iter) {
+        // Fresh cache per iteration so each size pays for its own noise
+        HeightfieldCache heightfield(1 << 16);
+        auto start = std::chrono::steady_clock::now();
+        for (int cx = -genRadius; cx <= genRadius; ++cx) {
+            for (int cz = -genRadius; cz <= genRadius; ++cz) {
+                auto blocks = std::make_shared<ChunkVolume>(opts.storage);
+                generateChunkBlocks({cx, cz}, dims, TerrainSettings{}, NoiseOffset{}, *blocks, &heightfield);
+                grid[(cx + genRadius) * genSide + (cz + genRadius)] = std::move(blocks);
+            }
+        }
+        result.generateMs = std::min(result.generateMs, elapsedMs(start));
+
+        auto gridAt = [&](int cx, int cz) { return grid[(cx + genRadius) * genSide + (cz + genRadius)]; };
+        result.chunks = 0;
+        result.blockBytes = 0;
+        result.meshBytes = 0;
+        result.vertices = 0;
+        result.drawRecords = 0;
+        start = std::chrono::steady_clock::now();
+        for (int cx = -viewDistance; cx <= viewDistance; ++cx) {
+            for (int cz = -viewDistance; cz <= viewDistance; ++cz) {
+                ChunkNeighbourhood neighbourhood;
+                neighbourhood.center = gridAt(cx, cz);
+                neighbourhood.west = gridAt(cx - 1, cz);
+                neighbourhood.east = gridAt(cx + 1, cz);
+                neighbourhood.north = gridAt(cx, cz - 1);
+                neighbourhood.south = gridAt(cx, cz + 1);
+                vertices.clear();
+                buildChunkVertices({cx, cz}, dims, neighbourhood, vertices, opts.meshing);
+                ++result.chunks;
+                result.blockBytes += neighbourhood.center->memoryBytes();
+                if (!vertices.empty()) {
+                    ++result.drawRecords;
+                    result.vertices += vertices.size();
+                    const size_t reserved = (vertices.size() + GRANULE_VERTICES - 1) / GRANULE_VERTICES * GRANULE_VERTICES;
+                    result.meshBytes += reserved * sizeof(PackedChunkVertex);
+                }
+            }
+        }
+        result.meshMs = std::min(result.meshMs, elapsedMs(start));
+    }
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    SweepOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage();
+        return 1;
+    }
+
+    std::cout << "chunk_sweep: view radius " << opts.viewBlocks << " blocks, height "
+              << opts.chunkHeight << ", " << meshingModeName(opts.meshing) << " meshing, "
+              << chunkStorageName(opts.storage) << " storage, best of " << opts.iterations << std::endl;
+    std::cout << std::left << std::setw(8) << "size" << std::setw(8) << "span" << std::setw(9) << "chunks" << std::setw(11) << "gen ms"
+              << std::setw(11) << "mesh ms" << std::setw(13) << "mesh us/ch" << std::setw(12) << "blocks KiB"
+              << std::setw(12) << "mesh KiB" << std::setw(12) << "vertices" << std::setw(8) << "draws"
+              << "indirect B" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (int size : opts.sizes) {
+        const SweepResult result = runSize(opts, size);
+        std::cout << std::left << std::setw(8) << size << std::setw(8) << result.spanBlocks << std::setw(9) << result.chunks
+                  << std::setw(11) << result.generateMs << std::setw(11) << result.meshMs
+                  << std::setw(13) << result.meshMs * 1000.0 / static_cast<double>(result.chunks)
+                  << std::setw(12) << result.blockBytes / 1024.0 << std::setw(12) << result.meshBytes / 1024.0
+                  << std::setw(12) << result.vertices << std::setw(8) << result.drawRecords
+                  << result.drawRecords * INDIRECT_COMMAND_BYTES << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Mesher microbenchmark: naive, greedy and binary (column bitmask) meshing on the same padded chunks.
+// Gathering the padded volumes is done up front, so the timings are face extraction plus vertex output only.
+// Also checks that the binary mesher emits exactly the naive mesher's faces.
+//
+//   run/mesher_bench [--chunk-size N] [--chunk-height N] [--view-distance N] [--iterations N]
+#include "chunk.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+struct BenchOptions {
+    ChunkDimensions dims;
+    int viewDistance = 8;
+    int iterations = 20;
+};
+
+void printUsage() {
+    std::cout << "usage: mesher_bench [--chunk-size N] [--chunk-height N] [--view-distance N] [--iterations N]" << std::endl;
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--chunk-size") opts.dims.size = std::atoi(value);
+        else if (arg == "--chunk-height") opts.dims.height = std::atoi(value);
+        else if (arg == "--view-distance") opts.viewDistance = std::atoi(value);
+        else if (arg == "--iterations") opts.iterations = std::atoi(value);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (opts.dims.size < 1 || opts.dims.height < 4 || opts.viewDistance < 0 || opts.iterations < 1) {
+        std::cerr << "Invalid chunk size/height, view distance or iteration count" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// The vertices of one quad, as raw bytes; sorting these compares meshes independent of emission order
+using Face = std::array<uint8_t, QUAD_VERTICES * sizeof(PackedChunkVertex)>;
+
+std::vector<Face> sortedFaces(const std::vector<PackedChunkVertex>& vertices) {
+    std::vector<Face> faces(vertices.size() / QUAD_VERTICES);
+    for (size_t i = 0; i < faces.size(); ++i) {
+        std::memcpy(faces[i].data(), &vertices[i * QUAD_VERTICES], sizeof(Face));
+    }
+    std::sort(faces.begin(), faces.end());
+    return faces;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage();
+        return 1;
+    }
+
+    const ChunkDimensions& dims = opts.dims;
+    const int genRadius = opts.viewDistance + 1;
+    const int genSide = 2 * genRadius + 1;
+    std::vector<ChunkBlocks> grid(static_cast<size_t>(genSide) * genSide);
+    auto gridAt = [&](int cx, int cz) -> ChunkBlocks {
+        if (cx < -genRadius || cx > genRadius || cz < -genRadius || cz > genRadius) return nullptr;
+        return grid[(cx + genRadius) * genSide + (cz + genRadius)];
+    };
+    for (int cx = -genRadius; cx <= genRadius; ++cx) {
+        for (int cz = -genRadius; cz <= genRadius; ++cz) {
+            auto blocks = std::make_shared<ChunkVolume>();
+            generateChunkBlocks({cx, cz}, dims, TerrainSettings{}, NoiseOffset{}, *blocks);
+            grid[(cx + genRadius) * genSide + (cz + genRadius)] = std::move(blocks);
+        }
+    }
+
+    std::vector<PaddedChunkBlocks> padded;
+    for (int cx = -opts.viewDistance; cx <= opts.viewDistance; ++cx) {
+        for (int cz = -opts.viewDistance; cz <= opts.viewDistance; ++cz) {
+            ChunkNeighbourhood neighbourhood;
+            neighbourhood.center = gridAt(cx, cz);
+            neighbourhood.west = gridAt(cx - 1, cz);
+            neighbourhood.east = gridAt(cx + 1, cz);
+            neighbourhood.north = gridAt(cx, cz - 1);
+            neighbourhood.south = gridAt(cx, cz + 1);
+            padded.emplace_back();
+            gatherPaddedBlocks(dims, neighbourhood, padded.back());
+        }
+    }
+
+    std::cout << "mesher_bench: chunk " << dims.size << "x" << dims.height << "x" << dims.size << ", "
+              << padded.size() << " chunks, " << opts.iterations << " iterations, best time per chunk" << std::endl;
+
+    const MeshingMode modes[] = {MeshingMode::Naive, MeshingMode::Greedy, MeshingMode::Binary};
+    std::vector<PackedChunkVertex> vertices;
+    vertices.reserve(1 << 16);
+    double naiveNs = 0.0;
+    for (MeshingMode mode : modes) {
+        double best = 1e30;
+        long long vertexCount = 0;
+        for (int iter = 0; iter < opts.iterations; ++iter) {
+            vertexCount = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (const PaddedChunkBlocks& chunk : padded) {
+                vertices.clear();
+                buildChunkVertices(chunk, vertices, mode);
+                vertexCount += static_cast<long long>(vertices.size());
+            }
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        const double ns = best * 1e9 / static_cast<double>(padded.size());
+        if (mode == MeshingMode::Naive) naiveNs = ns;
+        std::cout << "  " << meshingModeName(mode) << ": " << std::fixed << std::setprecision(0) << ns << " ns/chunk, "
+                  << vertexCount << " vertices, speedup vs naive: " << std::setprecision(2) << naiveNs / ns << "x" << std::endl;
+    }
+
+    // Same set of faces as naive, chunk by chunk
+    std::vector<PackedChunkVertex> naive;
+    for (const PaddedChunkBlocks& chunk : padded) {
+        naive.clear();
+        vertices.clear();
+        buildChunkVertices(chunk, naive, MeshingMode::Naive);
+        buildChunkVertices(chunk, vertices, MeshingMode::Binary);
+        if (sortedFaces(naive) != sortedFaces(vertices)) {
+            std::cerr << "Binary mesher output differs from naive" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+// Headless chunk pipeline benchmark: terrain generation and CPU meshing throughput.
+// Needs no GL context, so it runs on GPU-less build boxes.
+//
+//   run/voxel_bench [--chunk-size N] [--chunk-height N] [--view-distance N] [--iterations N] [--threads N]
+//                   [--continent-freq F] [--detail-freq F] [--continent-weight F] [--detail-weight F]
+//                   [--height-curve F] [--base-height F] [--height-range F] [--seed-x F] [--seed-z F]
+//                   [--noise-kernel scalar|sse41|avx2] [--no-heightfield-cache] [--meshing naive|greedy|binary]
+//                   [--chunk-storage sections|runs]
+#include "chunk.h"
+#include "heightfield.h"
+#include "job_pool.h"
+#include "noise.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+struct BenchOptions {
+    ChunkDimensions dims;
+    TerrainSettings terrain;
+    NoiseOffset offset;
+    int viewDistance = 8;
+    int iterations = 5;
+    // 1 -> run inline on the main thread, 0 -> JobPool default (hardware threads - 1)
+    int threads = 1;
+    bool heightfieldCache = true;
+    MeshingMode meshing = MeshingMode::Naive;
+    ChunkStorage storage = ChunkStorage::Sections;
+};
+
+void printUsage() {
+    std::cout << "usage: voxel_bench [--chunk-size N] [--chunk-height N] [--view-distance N] [--iterations N] [--threads N]\n"
+              << "                   [--continent-freq F] [--detail-freq F] [--continent-weight F] [--detail-weight F]\n"
+              << "                   [--height-curve F] [--base-height F] [--height-range F] [--seed-x F] [--seed-z F]\n"
+              << "                   [--noise-kernel scalar|sse41|avx2] [--no-heightfield-cache] [--meshing naive|greedy|binary]\n"
+              << "                   [--chunk-storage sections|runs]" << std::endl;
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        }
+        if (arg == "--no-heightfield-cache") {
+            opts.heightfieldCache = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--chunk-size") opts.dims.size = std::atoi(value);
+        else if (arg == "--chunk-height") opts.dims.height = std::atoi(value);
+        else if (arg == "--view-distance") opts.viewDistance = std::atoi(value);
+        else if (arg == "--iterations") opts.iterations = std::atoi(value);
+        else if (arg == "--threads") opts.threads = std::atoi(value);
+        else if (arg == "--continent-freq") opts.terrain.continentFreq = std::strtof(value, nullptr);
+        else if (arg == "--detail-freq") opts.terrain.detailFreq = std::strtof(value, nullptr);
+        else if (arg == "--continent-weight") opts.terrain.continentWeight = std::strtof(value, nullptr);
+        else if (arg == "--detail-weight") opts.terrain.detailWeight = std::strtof(value, nullptr);
+        else if (arg == "--height-curve") opts.terrain.heightCurve = std::strtof(value, nullptr);
+        else if (arg == "--base-height") opts.terrain.baseHeightFraction = std::strtof(value, nullptr);
+        else if (arg == "--height-range") opts.terrain.heightRangeFraction = std::strtof(value, nullptr);
+        else if (arg == "--seed-x") opts.offset.x = std::strtof(value, nullptr);
+        else if (arg == "--seed-z") opts.offset.z = std::strtof(value, nullptr);
+        else if (arg == "--noise-kernel") {
+            const NoiseKernel kernels[] = {NoiseKernel::Scalar, NoiseKernel::Sse41, NoiseKernel::Avx2};
+            bool found = false;
+            for (NoiseKernel kernel : kernels) {
+                if (std::strcmp(value, noiseKernelName(kernel)) == 0) {
+                    found = true;
+                    if (!setNoiseKernel(kernel)) {
+                        std::cerr << "Noise kernel " << value << " is not supported on this CPU" << std::endl;
+                        return false;
+                    }
+                }
+            }
+            if (!found) {
+                std::cerr << "Unknown noise kernel " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--meshing") {
+            if (!parseMeshingMode(value, opts.meshing)) {
+                std::cerr << "Unknown meshing mode " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--chunk-storage") {
+            if (!parseChunkStorage(value, opts.storage)) {
+                std::cerr << "Unknown chunk storage " << value << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (opts.dims.size < 1 || opts.dims.height < 4 || opts.viewDistance < 0 || opts.iterations < 1 || opts.threads < 0) {
+        std::cerr << "Invalid chunk size/height, view distance or iteration count" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage();
+        return 1;
+    }
+
+    const ChunkDimensions& dims = opts.dims;
+    // Generate one ring beyond the view distance so border chunks have neighbours to mesh against
+    const int genRadius = opts.viewDistance + 1;
+    const int genSide = 2 * genRadius + 1;
+    const int viewSide = 2 * opts.viewDistance + 1;
+    const long long genChunks = static_cast<long long>(genSide) * genSide;
+    const long long viewChunks = static_cast<long long>(viewSide) * viewSide;
+
+    std::unique_ptr<JobPool> pool;
+    if (opts.threads != 1) {
+        pool = std::make_unique<JobPool>(static_cast<unsigned>(opts.threads));
+    }
+    // One job per row of chunks when threaded, inline otherwise
+    auto forEachRow = [&](int radius, const std::function<void(int)>& row) {
+        for (int cx = -radius; cx <= radius; ++cx) {
+            if (pool) {
+                pool->submit([&row, cx] { row(cx); });
+            } else {
+                row(cx);
+            }
+        }
+        if (pool) {
+            pool->waitIdle();
+        }
+    };
+
+    std::cout << "voxel_bench: chunk " << dims.size << "x" << dims.height << "x" << dims.size
+              << ", view distance " << opts.viewDistance
+              << " (" << viewChunks << " meshed, " << genChunks << " generated), "
+              << opts.iterations << " iterations, "
+              << (pool ? pool->threadCount() : 1) << " thread(s), "
+              << noiseKernelName(getNoiseKernel()) << " noise, "
+              << meshingModeName(opts.meshing) << " meshing, " << chunkStorageName(opts.storage) << " storage" << std::endl;
+
+    std::vector<ChunkBlocks> grid(genChunks);
+    auto gridIndex = [&](int cx, int cz) {
+        return (cx + genRadius) * genSide + (cz + genRadius);
+    };
+
+    HeightfieldCache heightfield;
+    HeightfieldCache* heightfieldPtr = opts.heightfieldCache ? &heightfield : nullptr;
+
+    double bestGen = 1e30, bestMesh = 1e30, totalGen = 0.0, totalMesh = 0.0;
+    std::vector<long long> rowVertices(viewSide, 0);
+    long long vertexCount = 0;
+
+    for (int iter = 0; iter < opts.iterations; ++iter) {
+        // Start every iteration cold so the cache only helps between neighbouring chunks
+        heightfield.clear();
+        heightfield.resetStats();
+        auto genStart = std::chrono::steady_clock::now();
+        forEachRow(genRadius, [&](int cx) {
+            for (int cz = -genRadius; cz <= genRadius; ++cz) {
+                auto blocks = std::make_shared<ChunkVolume>(opts.storage);
+                generateChunkBlocks({cx, cz}, dims, opts.terrain, opts.offset, *blocks, heightfieldPtr);
+                grid[gridIndex(cx, cz)] = std::move(blocks);
+            }
+        });
+        double genTime = secondsSince(genStart);
+
+        auto meshStart = std::chrono::steady_clock::now();
+        forEachRow(opts.viewDistance, [&](int cx) {
+            std::vector<PackedChunkVertex> vertices;
+            vertices.reserve(20000);
+            long long count = 0;
+            for (int cz = -opts.viewDistance; cz <= opts.viewDistance; ++cz) {
+                ChunkNeighbourhood neighbourhood;
+                neighbourhood.center = grid[gridIndex(cx, cz)];
+                neighbourhood.west = grid[gridIndex(cx - 1, cz)];
+                neighbourhood.east = grid[gridIndex(cx + 1, cz)];
+                neighbourhood.north = grid[gridIndex(cx, cz - 1)];
+                neighbourhood.south = grid[gridIndex(cx, cz + 1)];
+                vertices.clear();
+                buildChunkVertices({cx, cz}, dims, neighbourhood, vertices, opts.meshing);
+                count += static_cast<long long>(vertices.size());
+            }
+            rowVertices[cx + opts.viewDistance] = count;
+        });
+        double meshTime = secondsSince(meshStart);
+        vertexCount = 0;
+        for (long long count : rowVertices) vertexCount += count;
+
+        bestGen = std::min(bestGen, genTime);
+        bestMesh = std::min(bestMesh, meshTime);
+        totalGen += genTime;
+        totalMesh += meshTime;
+    }
+
+    const double columns = static_cast<double>(genChunks) * dims.size * dims.size;
+    const double meanGen = totalGen / opts.iterations;
+    const double meanMesh = totalMesh / opts.iterations;
+
+    std::cout << "generate: best " << bestGen * 1e3 << " ms, mean " << meanGen * 1e3 << " ms, "
+              << genChunks / bestGen << " chunks/s, "
+              << bestGen * 1e9 / columns << " ns/column" << std::endl;
+    std::cout << "mesh:     best " << bestMesh * 1e3 << " ms, mean " << meanMesh * 1e3 << " ms, "
+              << viewChunks / bestMesh << " chunks/s, "
+              << vertexCount / bestMesh << " vertices/s, "
+              << vertexCount << " vertices ("
+              << vertexCount * sizeof(PackedChunkVertex) / 1024 << " KiB)" << std::endl;
+    if (opts.heightfieldCache) {
+        HeightfieldCache::Stats cacheStats = heightfield.getStats();
+        std::cout << "heightfield cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, "
+                  << cacheStats.evictions << " evictions, " << cacheStats.tiles << " tiles (last iteration)" << std::endl;
+    }
+    return 0;
+}
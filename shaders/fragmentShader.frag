@@ -2,47 +2,96 @@
 
 in vec4 vColor;
 in vec3 vNormal;
-in vec4 vFragPosLightSpace;
 in vec3 vWorldPos;
+in float vViewDepth;
 
 out vec4 FragColor;
 
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-uniform vec3 ambientColor;
-uniform sampler2D shadowMap;
-uniform vec2 shadowTexelSize;
+// Per-frame camera and light state, shared by every program (FrameUniformBlock in renderer.cpp)
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 cascadeLightSpace[4];
+    vec4 cascadeSplits;     // view depth where each cascade ends
+    vec4 cascadeTexelDepth; // depth-buffer units per texel width, per cascade
+    vec4 lightDir;          // xyz
+    vec4 lightColor;        // rgb
+    vec4 ambientColor;      // rgb
+    vec4 shadowTexelSize;   // xy, z = cascade count
+};
+
+// One depth layer per cascade, with hardware depth comparison (GL_TEXTURE_COMPARE_MODE): a fetch returns
+// the lit fraction of the 2x2 texels around the sample point
+uniform sampler2DArrayShadow shadowMap;
+
+// Filter variant, defined by Renderer::initialise() when it loads this file (see ShadowFilter):
+// SHADOW_FILTER_HARD, SHADOW_FILTER_POISSON4, SHADOW_FILTER_PCF3X3 or SHADOW_FILTER_PCF5X5
+#if !defined(SHADOW_FILTER_HARD) && !defined(SHADOW_FILTER_POISSON4) && !defined(SHADOW_FILTER_PCF3X3)
+#define SHADOW_FILTER_PCF5X5
+#endif
+
+#ifdef SHADOW_FILTER_POISSON4
+const vec2 poissonDisk[4] = vec2[4](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760)
+);
+#endif
+
+// Lit fraction at `coords` (xy in the layer, z the biased receiver depth) of the cascade's layer
+float shadowLit(vec3 coords, int cascade) {
+    float layer = float(cascade);
+#if defined(SHADOW_FILTER_HARD)
+    return texture(shadowMap, vec4(coords.xy, layer, coords.z));
+#elif defined(SHADOW_FILTER_POISSON4)
+    float lit = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        vec2 offset = poissonDisk[i] * 1.5 * shadowTexelSize.xy;
+        lit += texture(shadowMap, vec4(coords.xy + offset, layer, coords.z));
+    }
+    return lit * 0.25;
+#else
+#if defined(SHADOW_FILTER_PCF3X3)
+    const int radius = 1;
+#else
+    const int radius = 2;
+#endif
+    float lit = 0.0;
+    for (int x = -radius; x <= radius; ++x) {
+        for (int y = -radius; y <= radius; ++y) {
+            vec2 offset = vec2(x, y) * shadowTexelSize.xy;
+            lit += texture(shadowMap, vec4(coords.xy + offset, layer, coords.z));
+        }
+    }
+    return lit / float((2 * radius + 1) * (2 * radius + 1));
+#endif
+}
 
 void main() {
     vec3 normal = normalize(vNormal);
-    vec3 lightDirN = normalize(-lightDir);
+    vec3 lightDirN = normalize(-lightDir.xyz);
     float diff = max(dot(normal, lightDirN), 0.0);
 
-    // Transform to shadow map space
-    vec3 projCoords = vFragPosLightSpace.xyz / vFragPosLightSpace.w;
-    projCoords = projCoords * 0.5 + 0.5;
+    // First cascade whose slice reaches this fragment; past the last one there are no shadows
+    int cascadeCount = int(shadowTexelSize.z);
+    int cascade = 0;
+    while (cascade < cascadeCount && vViewDepth > cascadeSplits[cascade]) {
+        cascade++;
+    }
 
+    // Faces turned away from the light get no diffuse light to shadow, so they skip the lookups
     float shadow = 0.0;
-    if (projCoords.z <= 1.0 && projCoords.x >= 0.0 && projCoords.x <= 1.0 && projCoords.y >= 0.0 && projCoords.y <= 1.0) {
-        // Slightly looser bias to fight peter-panning while keeping edges tight
-        float bias = max(0.0010, 0.0035 * (1.0 - diff));
-        float currentDepth = projCoords.z - bias;
-        float shadowSum = 0.0;
-        int samples = 0;
-        // 5x5 PCF kernel for cleaner edges
-        for (int x = -2; x <= 2; ++x) {
-            for (int y = -2; y <= 2; ++y) {
-                vec2 offset = vec2(x, y) * shadowTexelSize;
-                float closest = texture(shadowMap, projCoords.xy + offset).r;
-                shadowSum += currentDepth > closest ? 1.0 : 0.0;
-                samples++;
-            }
+    if (diff > 0.0 && cascade < cascadeCount) {
+        // Transform to the cascade's shadow map space (orthographic, so no divide)
+        vec3 projCoords = (cascadeLightSpace[cascade] * vec4(vWorldPos, 1.0)).xyz * 0.5 + 0.5;
+        if (projCoords.z <= 1.0 && projCoords.x >= 0.0 && projCoords.x <= 1.0 && projCoords.y >= 0.0 && projCoords.y <= 1.0) {
+            // Slightly looser bias to fight peter-panning while keeping edges tight, in texels of this cascade
+            float bias = cascadeTexelDepth[cascade] * max(5.0, 18.0 * (1.0 - diff));
+            shadow = 1.0 - shadowLit(vec3(projCoords.xy, projCoords.z - bias), cascade);
         }
-        shadow = shadowSum / float(samples);
     }
 
-    vec3 ambient = ambientColor;
-    vec3 diffuse = (1.0 - shadow) * diff * lightColor;
+    vec3 ambient = ambientColor.rgb;
+    vec3 diffuse = (1.0 - shadow) * diff * lightColor.rgb;
     vec3 color = vColor.rgb * (ambient + diffuse);
     FragColor = vec4(color, vColor.a);
 }
@@ -1,10 +1,29 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
+// Same packed chunk vertex as vertexShader.vert; only the position is needed here
+layout(location = 0) in uvec3 aPos;
 
-uniform mat4 model;
-uniform mat4 lightSpaceMatrix;
+// World position of each chunk's vertex (0, 0, 0), one texel per arena granule (see VertexArena)
+uniform samplerBuffer chunkOrigins;
+uniform int granuleVertices;
+
+// Per-frame camera and light state, shared by every program (FrameUniformBlock in renderer.cpp)
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 cascadeLightSpace[4];
+    vec4 cascadeSplits;     // view depth where each cascade ends
+    vec4 cascadeTexelDepth; // depth-buffer units per texel width, per cascade
+    vec4 lightDir;          // xyz
+    vec4 lightColor;        // rgb
+    vec4 ambientColor;      // rgb
+    vec4 shadowTexelSize;   // xy, z = cascade count
+};
+
+// Cascade (layer of the shadow map) being rendered
+uniform int cascade;
 
 void main() {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    vec3 origin = texelFetch(chunkOrigins, gl_VertexID / granuleVertices).xyz;
+    gl_Position = cascadeLightSpace[cascade] * vec4(vec3(aPos) + origin, 1.0);
 }
@@ -1,24 +1,53 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec4 aColor;
-layout(location = 2) in vec3 aNormal;
+// Packed chunk vertex (see PackedChunkVertex in chunk.h)
+layout(location = 0) in uvec3 aPos;       // block-corner position relative to the chunk
+layout(location = 1) in uvec2 aFaceBlock; // face index, block type
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat4 lightSpaceMatrix;
+// World position of each chunk's vertex (0, 0, 0), one texel per arena granule (see VertexArena)
+uniform samplerBuffer chunkOrigins;
+uniform int granuleVertices;
+
+// Per-frame camera and light state, shared by every program (FrameUniformBlock in renderer.cpp)
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 cascadeLightSpace[4];
+    vec4 cascadeSplits;     // view depth where each cascade ends
+    vec4 cascadeTexelDepth; // depth-buffer units per texel width, per cascade
+    vec4 lightDir;          // xyz
+    vec4 lightColor;        // rgb
+    vec4 ambientColor;      // rgb
+    vec4 shadowTexelSize;   // xy, z = cascade count
+};
 
 out vec4 vColor;
 out vec3 vNormal;
-out vec4 vFragPosLightSpace;
 out vec3 vWorldPos;
+out float vViewDepth;
+
+// Indexed by face: +Z, -Z, -X, +X, +Y, -Y
+const vec3 faceNormals[6] = vec3[6](
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0), vec3(-1.0, 0.0, 0.0),
+    vec3(1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0)
+);
+
+// Indexed by BlockType: air, grass, dirt, stone, water
+const vec4 blockColors[5] = vec4[5](
+    vec4(0.0, 0.0, 0.0, 0.0),
+    vec4(0.2, 0.7, 0.2, 1.0),
+    vec4(0.45, 0.27, 0.12, 1.0),
+    vec4(0.55, 0.55, 0.55, 1.0),
+    vec4(0.1, 0.3, 0.8, 0.65)
+);
 
 void main() {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    vec3 origin = texelFetch(chunkOrigins, gl_VertexID / granuleVertices).xyz;
+    vec4 worldPos = vec4(vec3(aPos) + origin, 1.0);
     vWorldPos = worldPos.xyz;
-    vColor = aColor;
-    vNormal = mat3(model) * aNormal;
-    vFragPosLightSpace = lightSpaceMatrix * worldPos;
-    gl_Position = projection * view * worldPos;
+    vColor = blockColors[min(aFaceBlock.y, 4u)];
+    vNormal = faceNormals[min(aFaceBlock.x, 5u)];
+    vec4 viewPos = view * worldPos;
+    vViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
 }
@@ -75,6 +75,13 @@ public:
         updateCameraVectors();
     }
 
+    // Set absolute yaw/pitch (degrees), e.g. when replaying a recorded camera path
+    void SetOrientation(float yaw, float pitch) {
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
     // Get the view matrix using glm::lookAt
     glm::mat4 GetViewMatrix() {
         return glm::lookAt(Position, Position + Front, Up);
@@ -0,0 +1,1165 @@
+#include "chunk.h"
+#include "heightfield.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define VOXEL_CHUNK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+// Surface height of every column of the chunk, indexed lz * size + lx
+void generateColumnHeights(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                           const TerrainSettings& settings, const NoiseOffset& offset,
+                           std::vector<int>& heights, HeightfieldCache* heightfield) {
+    int chunkMinX = chunk.first * dims.size;
+    int chunkMinZ = chunk.second * dims.size;
+
+    // Raw height noise for the chunk plus a one-column apron, then the 3x3 smoothing stencil over that grid
+    const int gridSize = dims.size + 2;
+    std::vector<float> grid(gridSize * gridSize);
+    if (heightfield) {
+        heightfield->sample(chunkMinX - 1, chunkMinZ - 1, gridSize, gridSize, settings, offset, grid.data());
+    } else {
+        HeightfieldCache::evaluate(chunkMinX - 1, chunkMinZ - 1, gridSize, gridSize, settings, offset, grid.data());
+    }
+    auto heightNoise = [&](int lx, int lz) {
+        return grid[(lz + 1) * gridSize + (lx + 1)];
+    };
+
+    heights.assign(dims.size * dims.size, 0);
+
+    for (int lx = 0; lx < dims.size; ++lx) {
+        for (int lz = 0; lz < dims.size; ++lz) {
+            float hCenter = heightNoise(lx, lz);
+            float hN = heightNoise(lx, lz - 1);
+            float hS = heightNoise(lx, lz + 1);
+            float hE = heightNoise(lx + 1, lz);
+            float hW = heightNoise(lx - 1, lz);
+            float hNE = heightNoise(lx + 1, lz - 1);
+            float hNW = heightNoise(lx - 1, lz - 1);
+            float hSE = heightNoise(lx + 1, lz + 1);
+            float hSW = heightNoise(lx - 1, lz + 1);
+
+            float sum = hCenter * settings.smoothingCenterWeight
+                      + (hN + hS + hE + hW) * settings.smoothingEdgeWeight
+                      + (hNE + hNW + hSE + hSW) * settings.smoothingDiagWeight;
+            float weight = settings.smoothingCenterWeight
+                         + 4.0f * settings.smoothingEdgeWeight
+                         + 4.0f * settings.smoothingDiagWeight;
+            float blended = sum / weight;
+            float heightValue = pow(blended * 0.5f + 0.5f, settings.heightCurve);
+
+            int baseHeight = static_cast<int>(dims.height * settings.baseHeightFraction);
+            int heightRange = static_cast<int>(dims.height * settings.heightRangeFraction);
+            int columnHeight = std::clamp(baseHeight + static_cast<int>(std::round(heightValue * heightRange)), 2, dims.height - 2);
+
+            // Clamp slope against immediate neighbors to keep chunk borders aligned
+            if (lx > 0) {
+                int west = heights[lz * dims.size + (lx - 1)];
+                columnHeight = std::clamp(columnHeight, west - 2, west + 2);
+            }
+            if (lz > 0) {
+                int north = heights[(lz - 1) * dims.size + lx];
+                columnHeight = std::clamp(columnHeight, north - 2, north + 2);
+            }
+
+            heights[lz * dims.size + lx] = columnHeight;
+        }
+    }
+}
+
+// Ground below this many blocks under the surface is stone, the layers above it dirt and a grass top
+constexpr int SOIL_DEPTH = 4;
+
+// Fills layers [y0, y1) from the column heights into `blocks`, which starts at layer y0 and is already air
+void fillColumnLayers(const ChunkDimensions& dims, const std::vector<int>& heights, int y0, int y1, uint8_t* blocks) {
+    for (int lz = 0; lz < dims.size; ++lz) {
+        for (int lx = 0; lx < dims.size; ++lx) {
+            const int columnHeight = heights[lz * dims.size + lx];
+            for (int y = y0; y < std::min(columnHeight, y1); ++y) {
+                BlockType type = BlockType::Stone;
+                if (y >= columnHeight - 1) {
+                    type = BlockType::Grass;
+                } else if (y >= columnHeight - SOIL_DEPTH) {
+                    type = BlockType::Dirt;
+                }
+                blocks[dims.blockIndex(lx, y - y0, lz)] = static_cast<uint8_t>(type);
+            }
+
+            if (columnHeight < dims.waterLevel) {
+                for (int y = std::max(columnHeight, y0); y <= dims.waterLevel && y < y1; ++y) {
+                    blocks[dims.blockIndex(lx, y - y0, lz)] = static_cast<uint8_t>(BlockType::Water);
+                }
+            }
+        }
+    }
+}
+} // namespace
+
+void generateChunkBlocks(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                         const TerrainSettings& settings, const NoiseOffset& offset,
+                         std::vector<uint8_t>& blocks, HeightfieldCache* heightfield) {
+    std::vector<int> heights;
+    generateColumnHeights(chunk, dims, settings, offset, heights, heightfield);
+    blocks.assign(dims.volume(), static_cast<uint8_t>(BlockType::Air));
+    fillColumnLayers(dims, heights, 0, dims.height, blocks.data());
+}
+
+void generateChunkBlocks(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                         const TerrainSettings& settings, const NoiseOffset& offset,
+                         ChunkVolume& volume, HeightfieldCache* heightfield) {
+    std::vector<int> heights;
+    generateColumnHeights(chunk, dims, settings, offset, heights, heightfield);
+    volume.reset(dims);
+
+    if (volume.storage() == ChunkStorage::Runs) {
+        // Same layers as fillColumnLayers; appendRun drops the empty ones and clamps to the chunk height
+        for (int lz = 0; lz < dims.size; ++lz) {
+            for (int lx = 0; lx < dims.size; ++lx) {
+                const int columnHeight = heights[lz * dims.size + lx];
+                volume.appendRun(static_cast<uint8_t>(BlockType::Stone), columnHeight - SOIL_DEPTH);
+                volume.appendRun(static_cast<uint8_t>(BlockType::Dirt), columnHeight - 1);
+                volume.appendRun(static_cast<uint8_t>(BlockType::Grass), columnHeight);
+                if (columnHeight < dims.waterLevel) {
+                    volume.appendRun(static_cast<uint8_t>(BlockType::Water), dims.waterLevel + 1);
+                }
+                volume.finishColumn();
+            }
+        }
+        return;
+    }
+
+    // Everything below the shallowest stone is stone; nothing is above the highest surface or water line
+    const auto range = std::minmax_element(heights.begin(), heights.end());
+    const int stoneTop = *range.first - SOIL_DEPTH;
+    const int groundTop = std::max(*range.second, std::min(dims.waterLevel + 1, dims.height));
+    for (int section = 0; section < volume.sectionCount(); ++section) {
+        const int y0 = section * ChunkVolume::SECTION_HEIGHT;
+        const int y1 = y0 + volume.sectionLayers(section);
+        if (y0 >= groundTop) {
+            continue; // already air
+        }
+        if (y1 <= stoneTop) {
+            volume.fillSection(section, BlockType::Stone);
+            continue;
+        }
+        fillColumnLayers(dims, heights, y0, y1, volume.beginSection(section));
+        volume.finishSection(section);
+    }
+}
+
+namespace {
+int popCount(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits; bits &= bits - 1) ++count;
+    return count;
+#endif
+}
+
+int lowestSetBit(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int bit = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// Dense blocks of the section being built on this thread (ChunkVolume::beginSection/finishSection)
+thread_local std::vector<uint8_t> sectionScratch;
+
+// Unpacks `count` blocks starting at block `first`; palette indices are Bits wide (1, 2 or 4), raw types at 8
+template <int Bits>
+void decodeBlocksScalar(const uint64_t* packed, const uint8_t* palette, int first, int count, uint8_t* out) {
+    constexpr int perWord = 64 / Bits;
+    constexpr uint64_t mask = (uint64_t(1) << Bits) - 1;
+    const int end = first + count;
+    for (int index = first; index < end;) {
+        uint64_t word = packed[index / perWord] >> ((index % perWord) * Bits);
+        const int run = std::min(end - index, perWord - index % perWord);
+        for (int i = 0; i < run; ++i) {
+            const uint8_t value = static_cast<uint8_t>(word & mask);
+            out[i] = Bits == 8 ? value : palette[value];
+            word >>= Bits;
+        }
+        out += run;
+        index += run;
+    }
+}
+
+#ifdef VOXEL_CHUNK_X86
+// Packed indices as a byte stream (little-endian words, so block i sits at bit i * Bits), 16 bytes per step.
+// Each nibble holds 4 / Bits indices; a 16-entry table per index position maps the nibble straight to that
+// block type, so one pshufb resolves 16 blocks. The per-position results are then interleaved back into
+// block order. Returns the number of bytes consumed (whole 16-byte steps only).
+template <int Bits>
+__attribute__((target("ssse3")))
+int decodeBlocksSsse3(const uint8_t* bytes, int byteCount, const uint8_t* palette, uint8_t* out) {
+    constexpr int perNibble = 4 / Bits;
+    constexpr int mask = (1 << Bits) - 1;
+    __m128i tables[perNibble];
+    for (int j = 0; j < perNibble; ++j) {
+        alignas(16) uint8_t table[16];
+        for (int n = 0; n < 16; ++n) {
+            table[n] = palette[(n >> (j * Bits)) & mask];
+        }
+        tables[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(table));
+    }
+    const __m128i lowNibbles = _mm_set1_epi8(0x0F);
+    int done = 0;
+    for (; done + 16 <= byteCount; done += 16) {
+        const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + done));
+        const __m128i lo = _mm_and_si128(packed, lowNibbles);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), lowNibbles);
+        // r[j] holds the j-th block of every input byte
+        __m128i r[2 * perNibble];
+        for (int j = 0; j < perNibble; ++j) {
+            r[j] = _mm_shuffle_epi8(tables[j], lo);
+            r[perNibble + j] = _mm_shuffle_epi8(tables[j], hi);
+        }
+        __m128i* target = reinterpret_cast<__m128i*>(out + done * (8 / Bits));
+        if constexpr (Bits == 4) {
+            _mm_storeu_si128(target + 0, _mm_unpacklo_epi8(r[0], r[1]));
+            _mm_storeu_si128(target + 1, _mm_unpackhi_epi8(r[0], r[1]));
+        } else {
+            // Pairs of positions, then pairs of pairs (and of quads for 1 bit), widening the unpack each time
+            __m128i pairs[2 * perNibble];
+            for (int j = 0; j < perNibble; ++j) {
+                pairs[2 * j] = _mm_unpacklo_epi8(r[2 * j], r[2 * j + 1]);
+                pairs[2 * j + 1] = _mm_unpackhi_epi8(r[2 * j], r[2 * j + 1]);
+            }
+            if constexpr (Bits == 2) {
+                _mm_storeu_si128(target + 0, _mm_unpacklo_epi16(pairs[0], pairs[2]));
+                _mm_storeu_si128(target + 1, _mm_unpackhi_epi16(pairs[0], pairs[2]));
+                _mm_storeu_si128(target + 2, _mm_unpacklo_epi16(pairs[1], pairs[3]));
+                _mm_storeu_si128(target + 3, _mm_unpackhi_epi16(pairs[1], pairs[3]));
+            } else {
+                __m128i quads[8];
+                for (int h = 0; h < 2; ++h) {
+                    quads[4 * h + 0] = _mm_unpacklo_epi16(pairs[4 * h + 0], pairs[4 * h + 2]);
+                    quads[4 * h + 1] = _mm_unpackhi_epi16(pairs[4 * h + 0], pairs[4 * h + 2]);
+                    quads[4 * h + 2] = _mm_unpacklo_epi16(pairs[4 * h + 1], pairs[4 * h + 3]);
+                    quads[4 * h + 3] = _mm_unpackhi_epi16(pairs[4 * h + 1], pairs[4 * h + 3]);
+                }
+                for (int q = 0; q < 4; ++q) {
+                    _mm_storeu_si128(target + 2 * q, _mm_unpacklo_epi32(quads[q], quads[4 + q]));
+                    _mm_storeu_si128(target + 2 * q + 1, _mm_unpackhi_epi32(quads[q], quads[4 + q]));
+                }
+            }
+        }
+    }
+    return done;
+}
+
+bool hasSsse3() {
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+#endif
+
+template <int Bits>
+void decodeBlocks(const uint64_t* packed, const uint8_t* palette, int first, int count, uint8_t* out) {
+#ifdef VOXEL_CHUNK_X86
+    constexpr int perByte = 8 / Bits;
+    if (Bits < 8 && count >= 32 * perByte && hasSsse3()) {
+        // Scalar up to a byte boundary, then whole 16-byte steps, then the scalar tail
+        const int head = (perByte - first % perByte) % perByte;
+        decodeBlocksScalar<Bits>(packed, palette, first, head, out);
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(packed) + (first + head) / perByte;
+        constexpr int simdBits = Bits < 8 ? Bits : 4; // Bits == 8 never gets here
+        const int decoded = head + decodeBlocksSsse3<simdBits>(bytes, (count - head) / perByte, palette, out + head) * perByte;
+        decodeBlocksScalar<Bits>(packed, palette, first + decoded, count - decoded, out + decoded);
+        return;
+    }
+#endif
+    decodeBlocksScalar<Bits>(packed, palette, first, count, out);
+}
+
+// Packs `count` blocks, Bits wide each, as palette indices (or raw types at 8 bits)
+template <int Bits>
+void encodeBlocks(const uint8_t* blocks, int count, const uint8_t* paletteIndex, std::vector<uint64_t>& packed) {
+    constexpr int perWord = 64 / Bits;
+    auto value = [&](int i) -> uint64_t { return Bits == 8 ? blocks[i] : paletteIndex[blocks[i]]; };
+    packed.resize((count + perWord - 1) / perWord);
+    const int fullWords = count / perWord;
+    for (int w = 0; w < fullWords; ++w) {
+        // Two interleaved accumulators so the ORs don't form one serial chain
+        const int first = w * perWord;
+        uint64_t even = 0, odd = 0;
+        for (int i = 0; i < perWord; i += 2) {
+            even |= value(first + i) << (i * Bits);
+            odd |= value(first + i + 1) << ((i + 1) * Bits);
+        }
+        packed[w] = even | odd;
+    }
+    if (fullWords * perWord < count) {
+        uint64_t word = 0;
+        for (int i = fullWords * perWord; i < count; ++i) {
+            word |= value(i) << ((i - fullWords * perWord) * Bits);
+        }
+        packed[fullWords] = word;
+    }
+}
+
+void decodeBlocks(int bits, const uint64_t* packed, const uint8_t* palette, int first, int count, uint8_t* out) {
+    switch (bits) {
+    case 1: decodeBlocks<1>(packed, palette, first, count, out); break;
+    case 2: decodeBlocks<2>(packed, palette, first, count, out); break;
+    case 4: decodeBlocks<4>(packed, palette, first, count, out); break;
+    default: decodeBlocks<8>(packed, palette, first, count, out); break;
+    }
+}
+} // namespace
+
+const char* chunkStorageName(ChunkStorage storage) {
+    return storage == ChunkStorage::Runs ? "runs" : "sections";
+}
+
+bool parseChunkStorage(const char* name, ChunkStorage& storage) {
+    if (std::strcmp(name, "sections") == 0) {
+        storage = ChunkStorage::Sections;
+    } else if (std::strcmp(name, "runs") == 0) {
+        storage = ChunkStorage::Runs;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ChunkVolume::reset(const ChunkDimensions& dims) {
+    chunkSize = dims.size;
+    chunkHeight = dims.height;
+    sections.clear();
+    runs.clear();
+    columnStarts.clear();
+    runSectionContents.clear();
+    finishedColumns = 0;
+    if (blockStorage == ChunkStorage::Sections) {
+        sections.assign(sectionCount(), Section{});
+    } else {
+        // Columns not finished yet read as air: their start and end are both 0 (or start > end)
+        columnStarts.assign(static_cast<size_t>(dims.size) * dims.size + 1, 0);
+        runSectionContents.assign(sectionCount(), 0);
+    }
+}
+
+void ChunkVolume::assign(const ChunkDimensions& dims, const std::vector<uint8_t>& blocks) {
+    reset(dims);
+    if (blockStorage == ChunkStorage::Runs) {
+        for (int lz = 0; lz < dims.size; ++lz) {
+            for (int lx = 0; lx < dims.size; ++lx) {
+                for (int ly = 0; ly < dims.height; ++ly) {
+                    appendRun(blocks[dims.blockIndex(lx, ly, lz)], ly + 1);
+                }
+                finishColumn();
+            }
+        }
+        return;
+    }
+    const size_t layerBlocks = static_cast<size_t>(dims.size) * dims.size;
+    for (int section = 0; section < sectionCount(); ++section) {
+        const uint8_t* source = blocks.data() + static_cast<size_t>(section) * SECTION_HEIGHT * layerBlocks;
+        std::memcpy(beginSection(section), source, sectionLayers(section) * layerBlocks);
+        finishSection(section);
+    }
+}
+
+void ChunkVolume::copyRow(int ly, int lz, uint8_t* out) const {
+    if (blockStorage == ChunkStorage::Runs) {
+        for (int lx = 0; lx < chunkSize; ++lx) {
+            out[lx] = at(lx, ly, lz);
+        }
+        return;
+    }
+    const Section& section = sections[ly / SECTION_HEIGHT];
+    if (section.bits == 0) {
+        std::memset(out, section.palette[0], chunkSize);
+    } else {
+        const int first = ((ly % SECTION_HEIGHT) * chunkSize + lz) * chunkSize;
+        decodeBlocks(section.bits, section.packed.data(), section.palette, first, chunkSize, out);
+    }
+}
+
+void ChunkVolume::decodeSection(int section, uint8_t* out) const {
+    const int count = sectionLayers(section) * chunkSize * chunkSize;
+    if (blockStorage == ChunkStorage::Runs) {
+        std::memset(out, static_cast<uint8_t>(BlockType::Air), count);
+        const int y0 = section * SECTION_HEIGHT;
+        const int y1 = y0 + sectionLayers(section);
+        const int layerBlocks = chunkSize * chunkSize;
+        for (int lz = 0; lz < chunkSize; ++lz) {
+            for (int lx = 0; lx < chunkSize; ++lx) {
+                const BlockRun* column = columnRuns(lx, lz);
+                int bottom = 0;
+                for (int run = 0; run < columnRunCount(lx, lz) && bottom < y1; bottom = column[run++].top) {
+                    for (int y = std::max(bottom, y0); y < std::min<int>(column[run].top, y1); ++y) {
+                        out[(y - y0) * layerBlocks + lz * chunkSize + lx] = column[run].block;
+                    }
+                }
+            }
+        }
+        return;
+    }
+    const Section& source = sections[section];
+    if (source.bits == 0) {
+        std::memset(out, source.palette[0], count);
+    } else {
+        decodeBlocks(source.bits, source.packed.data(), source.palette, 0, count, out);
+    }
+}
+
+void ChunkVolume::toDense(std::vector<uint8_t>& blocks) const {
+    const size_t layerBlocks = static_cast<size_t>(chunkSize) * chunkSize;
+    blocks.resize(layerBlocks * chunkHeight);
+    for (int section = 0; section < sectionCount(); ++section) {
+        decodeSection(section, blocks.data() + static_cast<size_t>(section) * SECTION_HEIGHT * layerBlocks);
+    }
+}
+
+void ChunkVolume::fillSection(int section, BlockType block) {
+    Section& target = sections[section];
+    target.state = block == BlockType::Air ? SectionState::Empty : SectionState::Solid;
+    target.bits = 0;
+    target.paletteSize = 1;
+    target.palette[0] = static_cast<uint8_t>(block);
+    std::vector<uint64_t>().swap(target.packed);
+}
+
+uint8_t* ChunkVolume::beginSection(int section) {
+    sectionScratch.assign(static_cast<size_t>(sectionLayers(section)) * chunkSize * chunkSize,
+                          static_cast<uint8_t>(BlockType::Air));
+    return sectionScratch.data();
+}
+
+void ChunkVolume::finishSection(int section) {
+    const uint8_t* blocks = sectionScratch.data();
+    const int count = static_cast<int>(sectionScratch.size());
+    Section& target = sections[section];
+
+    // Which block types occur, a bit per type, then the palette in type order. Types below 64 (all of
+    // BlockType) are collected in registers; anything higher takes a second pass.
+    uint64_t present[4] = {};
+    uint64_t low0 = 0, low1 = 0;
+    uint8_t highBits = 0;
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        low0 |= uint64_t(1) << (blocks[i] & 63);
+        low1 |= uint64_t(1) << (blocks[i + 1] & 63);
+        highBits |= blocks[i] | blocks[i + 1];
+    }
+    if (i < count) {
+        low0 |= uint64_t(1) << (blocks[i] & 63);
+        highBits |= blocks[i];
+    }
+    if (highBits < 64) {
+        present[0] = low0 | low1;
+    } else {
+        for (i = 0; i < count; ++i) {
+            present[blocks[i] >> 6] |= uint64_t(1) << (blocks[i] & 63);
+        }
+    }
+    uint8_t paletteIndex[256];
+    int distinct = 0;
+    for (int word = 0; word < 4; ++word) {
+        for (uint64_t bits = present[word]; bits; bits &= bits - 1) {
+            const int block = word * 64 + lowestSetBit(bits);
+            if (distinct < MAX_PALETTE) {
+                target.palette[distinct] = static_cast<uint8_t>(block);
+                paletteIndex[block] = static_cast<uint8_t>(distinct);
+            }
+            ++distinct;
+        }
+    }
+    if (distinct == 1) {
+        fillSection(section, static_cast<BlockType>(blocks[0]));
+        return;
+    }
+    target.state = (present[0] & 1) ? SectionState::Mixed : SectionState::Solid; // bit 0: Air
+    target.bits = distinct <= 2 ? 1 : distinct <= 4 ? 2 : distinct <= MAX_PALETTE ? 4 : 8;
+    target.paletteSize = static_cast<uint8_t>(std::min(distinct, MAX_PALETTE));
+
+    switch (target.bits) {
+    case 1: encodeBlocks<1>(blocks, count, paletteIndex, target.packed); break;
+    case 2: encodeBlocks<2>(blocks, count, paletteIndex, target.packed); break;
+    case 4: encodeBlocks<4>(blocks, count, paletteIndex, target.packed); break;
+    default: encodeBlocks<8>(blocks, count, paletteIndex, target.packed); break;
+    }
+}
+
+void ChunkVolume::appendRun(uint8_t block, int top) {
+    top = std::min(top, chunkHeight);
+    const uint32_t first = columnStarts[finishedColumns];
+    const bool hasRuns = runs.size() > first;
+    if (top <= (hasRuns ? runs.back().top : 0)) {
+        return;
+    }
+    if (hasRuns && runs.back().block == block) {
+        runs.back().top = static_cast<uint16_t>(top);
+    } else {
+        runs.push_back({static_cast<uint16_t>(top), block});
+    }
+}
+
+void ChunkVolume::finishColumn() {
+    const uint32_t first = columnStarts[finishedColumns];
+    while (runs.size() > first && runs.back().block == static_cast<uint8_t>(BlockType::Air)) {
+        runs.pop_back();
+    }
+    int bottom = 0;
+    for (size_t run = first; run < runs.size(); ++run) {
+        markRunSections(bottom, runs[run].top, runs[run].block == static_cast<uint8_t>(BlockType::Air) ? SEEN_AIR : SEEN_BLOCKS);
+        bottom = runs[run].top;
+    }
+    markRunSections(bottom, chunkHeight, SEEN_AIR);
+    columnStarts[++finishedColumns] = static_cast<uint32_t>(runs.size());
+    if (finishedColumns == chunkSize * chunkSize) {
+        runs.shrink_to_fit(); // the volume is complete; don't keep the growth slack
+    }
+}
+
+void ChunkVolume::markRunSections(int y0, int y1, uint8_t seen) {
+    if (y0 >= y1) {
+        return;
+    }
+    for (int section = y0 / SECTION_HEIGHT; section <= (y1 - 1) / SECTION_HEIGHT; ++section) {
+        runSectionContents[section] |= seen;
+    }
+}
+
+size_t ChunkVolume::memoryBytes() const {
+    size_t bytes = sections.capacity() * sizeof(Section);
+    for (const Section& section : sections) {
+        bytes += section.packed.capacity() * sizeof(uint64_t);
+    }
+    bytes += runs.capacity() * sizeof(BlockRun) + columnStarts.capacity() * sizeof(uint32_t) + runSectionContents.capacity();
+    return bytes;
+}
+
+namespace {
+// Face corner templates (6 faces, 4 corners each, counter-clockwise from outside) as offsets from the
+// block's minimum corner; the index buffer makes triangles 0-1-2 and 2-3-0 of them
+const uint8_t faceCorners[6][QUAD_VERTICES * 3] = {
+    {0, 0, 1,   1, 0, 1,   1, 1, 1,   0, 1, 1}, // +Z (front)
+    {0, 0, 0,   0, 1, 0,   1, 1, 0,   1, 0, 0}, // -Z (back)
+    {0, 0, 0,   0, 0, 1,   0, 1, 1,   0, 1, 0}, // -X (left)
+    {1, 0, 0,   1, 1, 0,   1, 1, 1,   1, 0, 1}, // +X (right)
+    {0, 1, 0,   0, 1, 1,   1, 1, 1,   1, 1, 0}, // +Y (top)
+    {0, 0, 0,   1, 0, 0,   1, 0, 1,   0, 0, 1}  // -Y (bottom)
+};
+
+// Must match faceNormals in shaders/vertexShader.vert
+const int faceNormals[6][3] = {
+    {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}
+};
+
+// Per face: the axis the normal points along and the two axes spanning the face (0 = x, 1 = y, 2 = z)
+const int faceNormalAxis[6] = {2, 2, 0, 0, 1, 1};
+const int faceUAxis[6] = {0, 0, 2, 2, 0, 0};
+const int faceVAxis[6] = {1, 1, 1, 1, 2, 2};
+
+// Emits a face covering blocks [start, start + extent) along the face's two spanning axes
+// (extent is 1 along the normal axis). Greedy quads are the unit template stretched, so winding matches.
+void appendFace(int face, BlockType block, const int start[3], const int extent[3],
+                std::vector<PackedChunkVertex>& vertices) {
+    const uint8_t* corners = faceCorners[face];
+    for (int v = 0; v < QUAD_VERTICES; ++v) {
+        PackedChunkVertex vert;
+        vert.x = static_cast<uint16_t>(start[0] + corners[v * 3 + 0] * extent[0]);
+        vert.y = static_cast<uint16_t>(start[1] + corners[v * 3 + 1] * extent[1]);
+        vert.z = static_cast<uint16_t>(start[2] + corners[v * 3 + 2] * extent[2]);
+        vert.face = static_cast<uint8_t>(face);
+        vert.block = static_cast<uint8_t>(block);
+        vertices.push_back(vert);
+    }
+}
+
+// appendFace for a single block, writing into storage the caller has already sized
+PackedChunkVertex* writeUnitFace(int face, uint8_t block, int lx, int ly, int lz, PackedChunkVertex* out) {
+    const uint8_t* corners = faceCorners[face];
+    for (int v = 0; v < QUAD_VERTICES; ++v) {
+        out[v].x = static_cast<uint16_t>(lx + corners[v * 3 + 0]);
+        out[v].y = static_cast<uint16_t>(ly + corners[v * 3 + 1]);
+        out[v].z = static_cast<uint16_t>(lz + corners[v * 3 + 2]);
+        out[v].face = static_cast<uint8_t>(face);
+        out[v].block = block;
+    }
+    return out + QUAD_VERTICES;
+}
+
+// Bit 7 of every byte of `x` that is non-zero (non-air), everything else clear
+uint64_t nonZeroBytes(uint64_t x) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7Full;
+    return (((x & low7) + low7) | x) & ~low7;
+}
+} // namespace
+
+const char* meshingModeName(MeshingMode mode) {
+    switch (mode) {
+    case MeshingMode::Greedy: return "greedy";
+    case MeshingMode::Binary: return "binary";
+    default: return "naive";
+    }
+}
+
+bool parseMeshingMode(const char* name, MeshingMode& mode) {
+    if (std::strcmp(name, "naive") == 0) {
+        mode = MeshingMode::Naive;
+    } else if (std::strcmp(name, "greedy") == 0) {
+        mode = MeshingMode::Greedy;
+    } else if (std::strcmp(name, "binary") == 0) {
+        mode = MeshingMode::Binary;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+// Reused by every mesh built on a thread, so meshing doesn't allocate the padded volume each time
+thread_local PaddedChunkBlocks paddedScratch;
+// One decoded section while gathering
+thread_local std::vector<uint8_t> decodeScratch;
+
+// Occupancy bit per padded column (bit ly set = non-air block), indexed (lz + 1) * (size + 2) + (lx + 1)
+thread_local std::vector<uint64_t> columnScratch;
+
+// Sections per binary slab: a slab's layers plus the layer below and above must fit a 64-bit column
+constexpr int BINARY_SLAB_SECTIONS = (64 - 2) / ChunkVolume::SECTION_HEIGHT;
+
+// Same faces as the naive loop (a face is visible iff the neighbour across it is air), found per column:
+// +Y/-Y compare the column with itself shifted by one, the horizontal faces AND with the neighbouring
+// column's complement. Meshes layers [y0, y1) with bit 0 of each column holding layer y0 - 1, and emits
+// column by column, so the vertex order differs from naive.
+// StaticSize is the chunk footprint when known at compile time (see withChunkSize), 0 otherwise.
+template <int StaticSize>
+void buildBinarySlabVertices(const PaddedChunkBlocks& padded, int y0, int y1, std::vector<PackedChunkVertex>& vertices) {
+    const int size = StaticSize ? StaticSize : padded.size;
+    const int side = size + 2;
+    const uint8_t* blocks = padded.blocks.data();
+    std::vector<uint64_t>& columns = columnScratch;
+    columns.assign(static_cast<size_t>(side) * side, 0);
+    // Padded layers are side * side bytes in the same order as `columns`
+    const int strideY = side * side;
+    const uint8_t* bottom = blocks + y0 * strideY; // padded.index(-1, y0 - 1, -1)
+    const int layers = y1 - y0 + 2;
+    const uint64_t interior = ((uint64_t(1) << (y1 - y0)) - 1) << 1;
+    const int columnCount = side * side;
+    int c = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // 8 columns x 8 layers per step: each layer's 8 bytes become one bit per byte, shifted to that layer's
+    // bit, so after 8 layers byte k holds 8 occupancy bits of column c + k
+    const int fullLayers = layers & ~7;
+    for (; c + 8 <= columnCount; c += 8) {
+        for (int ly0 = 0; ly0 < fullLayers; ly0 += 8) {
+            uint64_t packed = 0;
+            for (int r = 0; r < 8; ++r) {
+                uint64_t word;
+                std::memcpy(&word, bottom + (ly0 + r) * strideY + c, sizeof(word));
+                packed |= (nonZeroBytes(word) >> 7) << r;
+            }
+            for (int k = 0; k < 8; ++k) {
+                columns[c + k] |= ((packed >> (8 * k)) & 0xFF) << ly0;
+            }
+        }
+        for (int ly = fullLayers; ly < layers; ++ly) {
+            for (int k = 0; k < 8; ++k) {
+                columns[c + k] |= static_cast<uint64_t>(bottom[ly * strideY + c + k] != static_cast<uint8_t>(BlockType::Air)) << ly;
+            }
+        }
+    }
+#endif
+    for (; c < columnCount; ++c) {
+        uint64_t bits = 0;
+        for (int ly = 0; ly < layers; ++ly) {
+            bits |= static_cast<uint64_t>(bottom[ly * strideY + c] != static_cast<uint8_t>(BlockType::Air)) << ly;
+        }
+        columns[c] = bits;
+    }
+
+    for (int lx = 0; lx < size; ++lx) {
+        for (int lz = 0; lz < size; ++lz) {
+            const int centre = (lz + 1) * side + (lx + 1);
+            const uint64_t column = columns[centre];
+            if (!(column & interior)) {
+                continue;
+            }
+            // Indexed by face: +Z, -Z, -X, +X, +Y, -Y
+            const uint64_t faces[6] = {
+                column & interior & ~columns[centre + side],
+                column & interior & ~columns[centre - side],
+                column & interior & ~columns[centre - 1],
+                column & interior & ~columns[centre + 1],
+                column & interior & ~(column >> 1),
+                column & interior & ~(column << 1)
+            };
+            uint64_t visible = faces[0] | faces[1] | faces[2] | faces[3] | faces[4] | faces[5];
+            int faceCount = 0;
+            for (uint64_t bits : faces) faceCount += popCount(bits);
+            // Size once per column and write in place rather than growing the vector face by face
+            const size_t base = vertices.size();
+            vertices.resize(base + static_cast<size_t>(faceCount) * QUAD_VERTICES);
+            PackedChunkVertex* out = vertices.data() + base;
+            while (visible) {
+                const int bit = lowestSetBit(visible);
+                visible &= visible - 1;
+                const uint8_t block = bottom[bit * strideY + centre];
+                for (int face = 0; face < 6; ++face) {
+                    if ((faces[face] >> bit) & 1) {
+                        out = writeUnitFace(face, block, lx, y0 + bit - 1, lz, out);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Runs of sections that need meshing, cut into slabs that fit a column mask
+template <int StaticSize>
+void buildBinaryChunkVertices(const PaddedChunkBlocks& padded, std::vector<PackedChunkVertex>& vertices) {
+    const int sectionCount = static_cast<int>(padded.meshSections.size());
+    for (int section = 0; section < sectionCount;) {
+        if (!padded.meshSections[section]) {
+            ++section;
+            continue;
+        }
+        int end = section + 1;
+        while (end < sectionCount && padded.meshSections[end] && end - section < BINARY_SLAB_SECTIONS) {
+            ++end;
+        }
+        const int y0 = section * ChunkVolume::SECTION_HEIGHT;
+        const int y1 = std::min(end * ChunkVolume::SECTION_HEIGHT, padded.height);
+        buildBinarySlabVertices<StaticSize>(padded, y0, y1, vertices);
+        section = end;
+    }
+}
+
+void resetPadded(const ChunkDimensions& dims, PaddedChunkBlocks& padded) {
+    padded.size = dims.size;
+    padded.height = dims.height;
+    padded.blocks.assign(static_cast<size_t>(dims.size + 2) * (dims.height + 2) * (dims.size + 2),
+                         static_cast<uint8_t>(BlockType::Air));
+    padded.meshSections.assign((dims.height + ChunkVolume::SECTION_HEIGHT - 1) / ChunkVolume::SECTION_HEIGHT, 1);
+}
+
+// Copies the chunk's own blocks row by row into the interior of the padded volume
+void copyInterior(const ChunkDimensions& dims, const std::vector<uint8_t>& blocks, PaddedChunkBlocks& padded) {
+    for (int ly = 0; ly < dims.height; ++ly) {
+        for (int lz = 0; lz < dims.size; ++lz) {
+            std::memcpy(&padded.blocks[padded.index(0, ly, lz)], &blocks[dims.blockIndex(0, ly, lz)], dims.size);
+        }
+    }
+}
+
+// Packed sections are decoded whole (long runs for the bulk decoder) and then copied row by row;
+// column runs are written straight down their columns
+void copyInterior(const ChunkVolume& volume, PaddedChunkBlocks& padded) {
+    std::vector<uint8_t>& decoded = decodeScratch;
+    const int size = volume.size();
+    if (volume.storage() == ChunkStorage::Runs) {
+        for (int lz = 0; lz < size; ++lz) {
+            for (int lx = 0; lx < size; ++lx) {
+                const BlockRun* column = volume.columnRuns(lx, lz);
+                int bottom = 0;
+                for (int run = 0; run < volume.columnRunCount(lx, lz); bottom = column[run++].top) {
+                    if (column[run].block == static_cast<uint8_t>(BlockType::Air)) {
+                        continue;
+                    }
+                    for (int y = bottom; y < column[run].top; ++y) {
+                        padded.blocks[padded.index(lx, y, lz)] = column[run].block;
+                    }
+                }
+            }
+        }
+        return;
+    }
+    for (int section = 0; section < volume.sectionCount(); ++section) {
+        const int y0 = section * ChunkVolume::SECTION_HEIGHT;
+        const int layers = volume.sectionLayers(section);
+        if (volume.isUniform(section)) {
+            const uint8_t block = volume.uniformBlock(section);
+            if (block == static_cast<uint8_t>(BlockType::Air)) {
+                continue; // the padded volume starts as air
+            }
+            for (int ly = y0; ly < y0 + layers; ++ly) {
+                for (int lz = 0; lz < size; ++lz) {
+                    std::memset(&padded.blocks[padded.index(0, ly, lz)], block, size);
+                }
+            }
+            continue;
+        }
+        decoded.resize(static_cast<size_t>(layers) * size * size);
+        volume.decodeSection(section, decoded.data());
+        for (int ly = 0; ly < layers; ++ly) {
+            for (int lz = 0; lz < size; ++lz) {
+                std::memcpy(&padded.blocks[padded.index(0, y0 + ly, lz)], &decoded[(ly * size + lz) * size], size);
+            }
+        }
+    }
+}
+
+// A section needs meshing unless it is empty, or solid with solid sections above, below and on all four sides.
+// The layers under the chunk and beyond missing neighbours are air, so those borders always need meshing.
+void markMeshSections(const ChunkNeighbourhood& neighbourhood, PaddedChunkBlocks& padded) {
+    const ChunkVolume& centre = *neighbourhood.center;
+    auto solid = [](const ChunkBlocks& volume, int section) {
+        return volume && volume->sectionState(section) == SectionState::Solid;
+    };
+    for (int section = 0; section < centre.sectionCount(); ++section) {
+        const SectionState state = centre.sectionState(section);
+        bool enclosed = state == SectionState::Solid && section > 0 && section + 1 < centre.sectionCount()
+            && centre.sectionState(section - 1) == SectionState::Solid
+            && centre.sectionState(section + 1) == SectionState::Solid
+            && solid(neighbourhood.west, section) && solid(neighbourhood.east, section)
+            && solid(neighbourhood.north, section) && solid(neighbourhood.south, section);
+        padded.meshSections[section] = state == SectionState::Empty || enclosed ? 0 : 1;
+    }
+}
+} // namespace
+
+void gatherPaddedBlocks(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                        const std::vector<uint8_t>& blocks, const BlockLookup& neighbourAt, PaddedChunkBlocks& padded) {
+    resetPadded(dims, padded);
+    copyInterior(dims, blocks, padded);
+    const int chunkMinX = chunk.first * dims.size;
+    const int chunkMinZ = chunk.second * dims.size;
+    for (int ly = 0; ly < dims.height; ++ly) {
+        for (int i = 0; i < dims.size; ++i) {
+            padded.blocks[padded.index(-1, ly, i)] = static_cast<uint8_t>(neighbourAt(chunkMinX - 1, ly, chunkMinZ + i));
+            padded.blocks[padded.index(dims.size, ly, i)] = static_cast<uint8_t>(neighbourAt(chunkMinX + dims.size, ly, chunkMinZ + i));
+            padded.blocks[padded.index(i, ly, -1)] = static_cast<uint8_t>(neighbourAt(chunkMinX + i, ly, chunkMinZ - 1));
+            padded.blocks[padded.index(i, ly, dims.size)] = static_cast<uint8_t>(neighbourAt(chunkMinX + i, ly, chunkMinZ + dims.size));
+        }
+    }
+}
+
+void gatherPaddedBlocks(const ChunkDimensions& dims, const ChunkNeighbourhood& neighbourhood, PaddedChunkBlocks& padded) {
+    resetPadded(dims, padded);
+    copyInterior(*neighbourhood.center, padded);
+    markMeshSections(neighbourhood, padded);
+    const int last = dims.size - 1;
+    for (int ly = 0; ly < dims.height; ++ly) {
+        // North/south borders are whole rows of the neighbouring chunk
+        if (neighbourhood.north) {
+            neighbourhood.north->copyRow(ly, last, &padded.blocks[padded.index(0, ly, -1)]);
+        }
+        if (neighbourhood.south) {
+            neighbourhood.south->copyRow(ly, 0, &padded.blocks[padded.index(0, ly, dims.size)]);
+        }
+        for (int lz = 0; lz < dims.size; ++lz) {
+            if (neighbourhood.west) {
+                padded.blocks[padded.index(-1, ly, lz)] = neighbourhood.west->at(last, ly, lz);
+            }
+            if (neighbourhood.east) {
+                padded.blocks[padded.index(dims.size, ly, lz)] = neighbourhood.east->at(0, ly, lz);
+            }
+        }
+    }
+}
+
+namespace {
+// Index distance to the neighbour across each face in a padded volume with the given padded row length
+void paddedNeighbourOffsets(int side, int offsets[6]) {
+    for (int face = 0; face < 6; ++face) {
+        offsets[face] = faceNormals[face][0] + faceNormals[face][1] * side * side + faceNormals[face][2] * side;
+    }
+}
+
+void buildGreedyChunkVertices(const PaddedChunkBlocks& padded, std::vector<PackedChunkVertex>& vertices) {
+    const uint8_t* blocks = padded.blocks.data();
+    const uint8_t air = static_cast<uint8_t>(BlockType::Air);
+    int neighbourOffset[6];
+    paddedNeighbourOffsets(padded.size + 2, neighbourOffset);
+
+    const int size[3] = {padded.size, padded.height, padded.size};
+    std::vector<uint8_t> mask;
+    for (int face = 0; face < 6; ++face) {
+        const int n = faceNormalAxis[face];
+        const int u = faceUAxis[face];
+        const int v = faceVAxis[face];
+        const int offset = neighbourOffset[face];
+        mask.resize(size[u] * size[v]);
+
+        for (int slice = 0; slice < size[n]; ++slice) {
+            if (n == 1 && !padded.meshLayer(slice)) {
+                continue;
+            }
+            // Block type of every visible face in this slice, Air where there is none
+            bool any = false;
+            int pos[3];
+            pos[n] = slice;
+            for (int iv = 0; iv < size[v]; ++iv) {
+                if (v == 1 && !padded.meshLayer(iv)) {
+                    std::fill_n(&mask[iv * size[u]], size[u], air);
+                    continue;
+                }
+                for (int iu = 0; iu < size[u]; ++iu) {
+                    pos[u] = iu;
+                    pos[v] = iv;
+                    const int index = padded.index(pos[0], pos[1], pos[2]);
+                    uint8_t block = blocks[index];
+                    if (blocks[index + offset] != air) {
+                        block = air;
+                    }
+                    mask[iv * size[u] + iu] = block;
+                    any = any || block != air;
+                }
+            }
+            if (!any) {
+                continue;
+            }
+
+            // Grow each unclaimed face along u, then along v while whole rows still match
+            for (int iv = 0; iv < size[v]; ++iv) {
+                for (int iu = 0; iu < size[u];) {
+                    uint8_t block = mask[iv * size[u] + iu];
+                    if (block == air) {
+                        ++iu;
+                        continue;
+                    }
+                    int width = 1;
+                    while (iu + width < size[u] && mask[iv * size[u] + iu + width] == block) {
+                        ++width;
+                    }
+                    int height = 1;
+                    for (; iv + height < size[v]; ++height) {
+                        const uint8_t* row = &mask[(iv + height) * size[u] + iu];
+                        if (std::count(row, row + width, block) != width) {
+                            break;
+                        }
+                    }
+                    for (int dv = 0; dv < height; ++dv) {
+                        std::fill_n(&mask[(iv + dv) * size[u] + iu], width, air);
+                    }
+
+                    int start[3];
+                    int extent[3] = {1, 1, 1};
+                    start[n] = slice;
+                    start[u] = iu;
+                    start[v] = iv;
+                    extent[u] = width;
+                    extent[v] = height;
+                    appendFace(face, static_cast<BlockType>(block), start, extent, vertices);
+                    iu += width;
+                }
+            }
+        }
+    }
+}
+
+template <int StaticSize>
+void buildNaiveChunkVertices(const PaddedChunkBlocks& padded, std::vector<PackedChunkVertex>& vertices) {
+    const int size = StaticSize ? StaticSize : padded.size;
+    const int side = size + 2;
+    const uint8_t* blocks = padded.blocks.data();
+    const uint8_t air = static_cast<uint8_t>(BlockType::Air);
+    int neighbourOffset[6];
+    paddedNeighbourOffsets(side, neighbourOffset);
+
+    for (int lx = 0; lx < size; ++lx) {
+        for (int ly = 0; ly < padded.height; ++ly) {
+            if (!padded.meshLayer(ly)) {
+                // Jump to the last layer of this section
+                ly = std::min(ly | (ChunkVolume::SECTION_HEIGHT - 1), padded.height - 1);
+                continue;
+            }
+            for (int lz = 0; lz < size; ++lz) {
+                const int index = ((ly + 1) * side + (lz + 1)) * side + (lx + 1);
+                const uint8_t block = blocks[index];
+                if (block == air) {
+                    continue;
+                }
+
+                bool drawFace[6];
+                bool anyFace = false;
+                for (int face = 0; face < 6; ++face) {
+                    drawFace[face] = blocks[index + neighbourOffset[face]] == air;
+                    anyFace = anyFace || drawFace[face];
+                }
+                if (!anyFace) {
+                    continue;
+                }
+
+                const int start[3] = {lx, ly, lz};
+                const int extent[3] = {1, 1, 1};
+                for (int face = 0; face < 6; ++face) {
+                    if (!drawFace[face]) continue;
+                    appendFace(face, static_cast<BlockType>(block), start, extent, vertices);
+                }
+            }
+        }
+    }
+}
+
+// A column of the run mesher's footprint; missing neighbours and the corners have no runs (all air)
+struct RunColumn {
+    const BlockRun* runs = nullptr;
+    int count = 0;
+};
+
+// Columns of the chunk plus its one-column border, indexed (lz + 1) * (size + 2) + (lx + 1)
+thread_local std::vector<RunColumn> runColumnScratch;
+
+// Calls fn(y0, y1) for each stretch of layers in [y0, y1) where the column is air
+template <typename Fn>
+void forEachAirSpan(const RunColumn& column, int y0, int y1, Fn&& fn) {
+    int spanStart = y0;
+    int bottom = 0;
+    for (int run = 0; run < column.count && bottom < y1; bottom = column.runs[run++].top) {
+        if (column.runs[run].top <= y0 || column.runs[run].block == static_cast<uint8_t>(BlockType::Air)) {
+            continue;
+        }
+        if (bottom > spanStart) {
+            fn(spanStart, bottom);
+        }
+        spanStart = column.runs[run].top;
+    }
+    if (spanStart < y1) {
+        fn(spanStart, y1); // everything above the last run is air
+    }
+}
+
+// Naive's faces from the column runs of a Runs neighbourhood. A run's -Y/+Y faces exist only at its ends
+// (when the run below/above is air, or it touches the bottom/top of the chunk); its side faces are where the
+// neighbouring column has air over the run's span, found by walking the two run lists side by side.
+// Emits column by column, so the vertex order differs from naive.
+void buildRunChunkVertices(const ChunkNeighbourhood& neighbourhood, std::vector<PackedChunkVertex>& vertices) {
+    const ChunkVolume& centre = *neighbourhood.center;
+    const int size = centre.size();
+    const int side = size + 2;
+    std::vector<RunColumn>& columns = runColumnScratch;
+    columns.assign(static_cast<size_t>(side) * side, RunColumn{});
+    auto columnOf = [](const ChunkVolume& volume, int lx, int lz) {
+        return RunColumn{volume.columnRuns(lx, lz), volume.columnRunCount(lx, lz)};
+    };
+    for (int lz = 0; lz < size; ++lz) {
+        for (int lx = 0; lx < size; ++lx) {
+            columns[(lz + 1) * side + (lx + 1)] = columnOf(centre, lx, lz);
+        }
+    }
+    for (int i = 0; i < size; ++i) {
+        if (neighbourhood.west) columns[(i + 1) * side] = columnOf(*neighbourhood.west, size - 1, i);
+        if (neighbourhood.east) columns[(i + 1) * side + size + 1] = columnOf(*neighbourhood.east, 0, i);
+        if (neighbourhood.north) columns[i + 1] = columnOf(*neighbourhood.north, i, size - 1);
+        if (neighbourhood.south) columns[(size + 1) * side + i + 1] = columnOf(*neighbourhood.south, i, 0);
+    }
+    // Column distance to the neighbour across each horizontal face (+Z, -Z, -X, +X)
+    const int sideOffsets[4] = {side, -side, -1, 1};
+    const int extent[3] = {1, 1, 1};
+
+    for (int lz = 0; lz < size; ++lz) {
+        for (int lx = 0; lx < size; ++lx) {
+            const int columnIndex = (lz + 1) * side + (lx + 1);
+            const RunColumn& column = columns[columnIndex];
+            int bottom = 0;
+            for (int run = 0; run < column.count; bottom = column.runs[run++].top) {
+                const uint8_t block = column.runs[run].block;
+                if (block == static_cast<uint8_t>(BlockType::Air)) {
+                    continue;
+                }
+                const int top = column.runs[run].top;
+                const BlockType type = static_cast<BlockType>(block);
+                for (int face = 0; face < 4; ++face) {
+                    forEachAirSpan(columns[columnIndex + sideOffsets[face]], bottom, top, [&](int y0, int y1) {
+                        for (int y = y0; y < y1; ++y) {
+                            const int start[3] = {lx, y, lz};
+                            appendFace(face, type, start, extent, vertices);
+                        }
+                    });
+                }
+                if (run + 1 == column.count || column.runs[run + 1].block == static_cast<uint8_t>(BlockType::Air)) {
+                    const int start[3] = {lx, top - 1, lz};
+                    appendFace(4, type, start, extent, vertices); // +Y
+                }
+                if (run == 0 || column.runs[run - 1].block == static_cast<uint8_t>(BlockType::Air)) {
+                    const int start[3] = {lx, bottom, lz};
+                    appendFace(5, type, start, extent, vertices); // -Y
+                }
+            }
+        }
+    }
+}
+
+bool allRunStorage(const ChunkNeighbourhood& neighbourhood) {
+    for (const ChunkBlocks* volume : {&neighbourhood.center, &neighbourhood.west, &neighbourhood.east,
+                                      &neighbourhood.north, &neighbourhood.south}) {
+        if (*volume && (*volume)->storage() != ChunkStorage::Runs) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Calls fn with std::integral_constant<int, size> for the power-of-two footprints, so their meshing loops
+// are compiled with constant bounds and strides; any other size gets integral_constant<int, 0> (runtime size)
+template <typename Fn>
+void withChunkSize(int size, Fn&& fn) {
+    switch (size) {
+    case 4: fn(std::integral_constant<int, 4>()); break;
+    case 8: fn(std::integral_constant<int, 8>()); break;
+    case 16: fn(std::integral_constant<int, 16>()); break;
+    case 32: fn(std::integral_constant<int, 32>()); break;
+    default: fn(std::integral_constant<int, 0>()); break;
+    }
+}
+} // namespace
+
+void buildChunkVertices(const PaddedChunkBlocks& padded, std::vector<PackedChunkVertex>& vertices, MeshingMode mode) {
+    if (mode == MeshingMode::Greedy) {
+        buildGreedyChunkVertices(padded, vertices);
+        return;
+    }
+    withChunkSize(padded.size, [&](auto staticSize) {
+        constexpr int StaticSize = decltype(staticSize)::value;
+        if (mode == MeshingMode::Binary) {
+            buildBinaryChunkVertices<StaticSize>(padded, vertices);
+        } else {
+            buildNaiveChunkVertices<StaticSize>(padded, vertices);
+        }
+    });
+}
+
+void buildChunkVertices(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                        const std::vector<uint8_t>& blocks, const BlockLookup& neighbourAt,
+                        std::vector<PackedChunkVertex>& vertices, MeshingMode mode) {
+    gatherPaddedBlocks(chunk, dims, blocks, neighbourAt, paddedScratch);
+    buildChunkVertices(paddedScratch, vertices, mode);
+}
+
+void buildChunkVertices(const std::pair<int, int>&, const ChunkDimensions& dims,
+                        const ChunkNeighbourhood& neighbourhood, std::vector<PackedChunkVertex>& vertices,
+                        MeshingMode mode) {
+    if (mode == MeshingMode::Naive && allRunStorage(neighbourhood)) {
+        buildRunChunkVertices(neighbourhood, vertices);
+        return;
+    }
+    gatherPaddedBlocks(dims, neighbourhood, paddedScratch);
+    buildChunkVertices(paddedScratch, vertices, mode);
+}
+
+uint8_t lightFacingFaces(float x, float y, float z) {
+    uint8_t mask = 0;
+    for (int face = 0; face < 6; ++face) {
+        if (faceNormals[face][0] * x + faceNormals[face][1] * y + faceNormals[face][2] * z < 0.0f) {
+            mask |= static_cast<uint8_t>(1u << face);
+        }
+    }
+    return mask;
+}
+
+size_t groupFacesFirst(std::vector<PackedChunkVertex>& vertices, uint8_t faceMask) {
+    // Every vertex of a quad has the quad's face, so partitioning vertices keeps quads whole
+    auto grouped = std::stable_partition(vertices.begin(), vertices.end(),
+        [faceMask](const PackedChunkVertex& v) { return (faceMask >> v.face) & 1u; });
+    return static_cast<size_t>(grouped - vertices.begin());
+}
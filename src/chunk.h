@@ -0,0 +1,310 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// GL-free chunk pipeline: terrain generation and CPU meshing.
+// Nothing in here touches OpenGL so it can be driven from benchmarks and headless tools.
+
+enum class BlockType : uint8_t {
+    Air = 0,
+    Grass,
+    Dirt,
+    Stone,
+    Water
+};
+
+struct TerrainSettings {
+    // Noise frequency for the large-scale landmasses (lower -> wider features)
+    float continentFreq = 0.0135f;
+    // Noise frequency for finer surface detail (higher -> more local variation)
+    float detailFreq = 0.0060f;
+    // Blend weights between the low-frequency and high-frequency noise
+    float continentWeight = 0.85f;
+    float detailWeight = 0.15f;
+    // Smoothing kernel weights (center, edges, diagonals) to reduce jagged steps
+    float smoothingCenterWeight = 4.0f;
+    float smoothingEdgeWeight = 2.0f;
+    float smoothingDiagWeight = 1.0f;
+    // Exponent applied to the normalized height to shape slopes/plateaus (<1 flattens)
+    float heightCurve = 0.98f;
+    // Fractions of CHUNK_HEIGHT used for base and variable height range
+    float baseHeightFraction = 0.34f;
+    float heightRangeFraction = 0.32f;
+};
+
+// Chunk footprint/height in blocks plus the world water line
+struct ChunkDimensions {
+    int size = 4;
+    int height = 32;
+    int waterLevel = 10;
+
+    int blockIndex(int lx, int ly, int lz) const {
+        return (ly * size + lz) * size + lx;
+    }
+    int volume() const {
+        return size * height * size;
+    }
+};
+
+// World-space offset added to noise lookups (the per-launch terrain seed)
+struct NoiseOffset {
+    float x = 0.0f;
+    float z = 0.0f;
+};
+
+// Chunk mesh vertex, 8 bytes. Position is a block-corner lattice point relative to the chunk's
+// minimum corner (world = chunk origin + position - 0.5, block centres sit on integers); normal and
+// colour are looked up in the vertex shader from the face index (+Z, -Z, -X, +X, +Y, -Y) and block type.
+struct PackedChunkVertex {
+    uint16_t x, y, z;
+    uint8_t face;
+    uint8_t block; // BlockType
+};
+static_assert(sizeof(PackedChunkVertex) == 8, "PackedChunkVertex must stay 8 bytes");
+
+// Meshes are lists of quads, 4 vertices each, drawn as the triangles 0-1-2 and 2-3-0 of every quad
+// through one shared index buffer (see VertexArena)
+constexpr int QUAD_VERTICES = 4;
+constexpr int QUAD_INDICES = 6;
+
+// What a vertical section holds, as far as meshing is concerned. Faces only exist between a non-air
+// block and air, so an Empty section has none and a Solid one only where a neighbouring section has air.
+enum class SectionState : uint8_t {
+    Empty, // all air
+    Solid, // no air (any mix of non-air types)
+    Mixed
+};
+
+// How a ChunkVolume keeps its blocks. Sections packs each SECTION_HEIGHT-tall section as palette indices;
+// Runs keeps every column as a list of runs from the bottom up, which for layered terrain (stone, dirt,
+// grass, water) is a handful of entries whatever the height.
+enum class ChunkStorage {
+    Sections,
+    Runs
+};
+
+const char* chunkStorageName(ChunkStorage storage);
+// Parses "sections"/"runs"; returns false for anything else
+bool parseChunkStorage(const char* name, ChunkStorage& storage);
+
+// Blocks [previous run's top, top) of a column are `block`; the first run starts at layer 0
+struct BlockRun {
+    uint16_t top;
+    uint8_t block; // BlockType
+};
+
+// A chunk's blocks split into SECTION_HEIGHT-tall vertical sections, each in ChunkDimensions::blockIndex
+// order relative to its bottom layer. With Sections storage every section is palette-compressed: its
+// distinct block types go in a small palette and each block stores a palette index in 0, 1, 2 or 4 bits
+// (0 = a single-type section such as open sky or deep stone), or its raw type in 8 bits when there are
+// more than 16 types. Indices never straddle a 64-bit word. The top section is shorter when the height
+// isn't a multiple. With Runs storage the blocks are column runs instead and sections only carry their
+// state. The storage is picked at construction and kept by reset/assign.
+class ChunkVolume {
+public:
+    static constexpr int SECTION_HEIGHT = 16; // power of two
+    static constexpr int MAX_PALETTE = 16;
+
+    ChunkVolume() = default;
+    explicit ChunkVolume(ChunkStorage storage) : blockStorage(storage) {}
+    // All air
+    explicit ChunkVolume(const ChunkDimensions& dims, ChunkStorage storage = ChunkStorage::Sections)
+        : blockStorage(storage) { reset(dims); }
+
+    void reset(const ChunkDimensions& dims);
+    // Replaces the contents from a dense dims.volume() array in blockIndex order
+    void assign(const ChunkDimensions& dims, const std::vector<uint8_t>& blocks);
+
+    ChunkStorage storage() const { return blockStorage; }
+    int size() const { return chunkSize; }
+    int height() const { return chunkHeight; }
+    int sectionCount() const { return (chunkHeight + SECTION_HEIGHT - 1) / SECTION_HEIGHT; }
+    int sectionLayers(int section) const {
+        return std::min(SECTION_HEIGHT, chunkHeight - section * SECTION_HEIGHT);
+    }
+    SectionState sectionState(int section) const {
+        if (blockStorage == ChunkStorage::Sections) return sections[section].state;
+        const uint8_t seen = runSectionContents[section];
+        if (!(seen & SEEN_BLOCKS)) return SectionState::Empty;
+        return (seen & SEEN_AIR) ? SectionState::Mixed : SectionState::Solid;
+    }
+    // Sections storage only: bits per block of the section's storage (0, 1, 2, 4 or 8)
+    int sectionBits(int section) const { return sections[section].bits; }
+    bool isUniform(int section) const { return sections[section].bits == 0; }
+    // The block type filling a uniform section
+    uint8_t uniformBlock(int section) const { return sections[section].palette[0]; }
+
+    uint8_t at(int lx, int ly, int lz) const {
+        if (blockStorage == ChunkStorage::Runs) {
+            const int column = lz * chunkSize + lx;
+            for (uint32_t run = columnStarts[column]; run < columnStarts[column + 1]; ++run) {
+                if (ly < runs[run].top) return runs[run].block;
+            }
+            return static_cast<uint8_t>(BlockType::Air);
+        }
+        const Section& section = sections[ly / SECTION_HEIGHT];
+        if (section.bits == 0) return section.palette[0];
+        const int index = ((ly % SECTION_HEIGHT) * chunkSize + lz) * chunkSize + lx;
+        const int bit = index * section.bits;
+        const uint32_t value = static_cast<uint32_t>(section.packed[bit >> 6] >> (bit & 63)) & ((1u << section.bits) - 1);
+        return section.bits == 8 ? static_cast<uint8_t>(value) : section.palette[value];
+    }
+    // Writes the size() blocks of row (ly, lz) to out
+    void copyRow(int ly, int lz, uint8_t* out) const;
+    // Writes the section's blocks (sectionLayers * size * size, blockIndex order from its bottom layer) to out
+    void decodeSection(int section, uint8_t* out) const;
+    void toDense(std::vector<uint8_t>& blocks) const;
+
+    // Makes the section uniform (no per-block storage)
+    void fillSection(int section, BlockType block);
+    // Dense scratch for the caller to fill with the section's blocks (sectionLayers * size * size bytes,
+    // all air), then finishSection packs it and picks the bit width. The scratch is per thread, so a
+    // thread builds one section at a time.
+    uint8_t* beginSection(int section);
+    void finishSection(int section);
+
+    // Runs storage only. A column's runs are maximal (neighbours differ) and stop at its highest non-air
+    // block; everything above is air, so an all-air column has none.
+    const BlockRun* columnRuns(int lx, int lz) const { return runs.data() + columnStarts[lz * chunkSize + lx]; }
+    int columnRunCount(int lx, int lz) const {
+        const int column = lz * chunkSize + lx;
+        return static_cast<int>(columnStarts[column + 1] - columnStarts[column]);
+    }
+    // Builds the runs column by column in (lz, lx) order after reset: appendRun extends the current column
+    // up to `top` (merging with the run below when the type matches), finishColumn closes it
+    void appendRun(uint8_t block, int top);
+    void finishColumn();
+
+    // Heap bytes held for blocks, plus the section table
+    size_t memoryBytes() const;
+
+private:
+    struct Section {
+        SectionState state = SectionState::Empty;
+        uint8_t bits = 0;
+        uint8_t paletteSize = 1;
+        uint8_t palette[MAX_PALETTE] = {static_cast<uint8_t>(BlockType::Air)};
+        std::vector<uint64_t> packed; // empty when bits == 0
+    };
+
+    // runSectionContents bits: what the finished columns put in each section
+    static constexpr uint8_t SEEN_AIR = 1;
+    static constexpr uint8_t SEEN_BLOCKS = 2;
+    void markRunSections(int y0, int y1, uint8_t seen);
+
+    ChunkStorage blockStorage = ChunkStorage::Sections;
+    int chunkSize = 0;
+    int chunkHeight = 0;
+    std::vector<Section> sections;
+    // Runs storage: every column's runs back to back, column c in [columnStarts[c], columnStarts[c + 1])
+    std::vector<BlockRun> runs;
+    std::vector<uint32_t> columnStarts;
+    std::vector<uint8_t> runSectionContents;
+    int finishedColumns = 0;
+};
+
+// Immutable chunk blocks, shared between the render thread and worker jobs
+using ChunkBlocks = std::shared_ptr<const ChunkVolume>;
+
+// A chunk plus its four horizontal neighbours: all the data needed to mesh it
+struct ChunkNeighbourhood {
+    ChunkBlocks center;
+    ChunkBlocks west;  // -X
+    ChunkBlocks east;  // +X
+    ChunkBlocks north; // -Z
+    ChunkBlocks south; // +Z
+};
+
+// Naive emits one quad per exposed block face; greedy merges coplanar faces of the same block type
+// into maximal rectangles per slice, which is far fewer vertices on plains, cliffs and water.
+// Binary emits the same faces as naive but finds them a whole column at a time from per-column
+// occupancy bitmasks (shifts and ANDs instead of six neighbour reads per block), up to three
+// sections per 64-bit column. All three skip sections that can't have visible faces.
+enum class MeshingMode {
+    Naive,
+    Greedy,
+    Binary
+};
+
+const char* meshingModeName(MeshingMode mode);
+// Parses "naive"/"greedy"/"binary"; returns false for anything else
+bool parseMeshingMode(const char* name, MeshingMode& mode);
+
+// Resolves blocks outside the chunk being meshed (world coordinates)
+using BlockLookup = std::function<BlockType(int worldX, int worldY, int worldZ)>;
+
+// Integer division rounding towards negative infinity (world -> chunk coordinates)
+inline int floorDiv(int a, int b) {
+    int q = a / b;
+    return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+// A chunk's blocks plus a one-block border copied from its four neighbours: (size + 2) x (height + 2) x (size + 2),
+// x fastest like ChunkDimensions::blockIndex. The layers below and above the chunk, the vertical corner columns
+// and borders towards missing neighbours are Air. Gathered once per mesh so every neighbour test in the
+// mesher is a read at a fixed offset from the block's own index.
+struct PaddedChunkBlocks {
+    int size = 0;
+    int height = 0;
+    std::vector<uint8_t> blocks;
+    // Per ChunkVolume section: 0 when no face inside it can be visible (empty, or solid and enclosed by solid
+    // sections), so the meshers skip its layers. Gathering from dense arrays marks every section 1.
+    std::vector<uint8_t> meshSections;
+
+    // Local chunk coordinates, each may be one step outside the chunk
+    int index(int lx, int ly, int lz) const {
+        return ((ly + 1) * (size + 2) + (lz + 1)) * (size + 2) + (lx + 1);
+    }
+    int strideZ() const { return size + 2; }
+    int strideY() const { return (size + 2) * (size + 2); }
+    bool meshLayer(int ly) const { return meshSections[ly / ChunkVolume::SECTION_HEIGHT] != 0; }
+};
+
+class HeightfieldCache;
+
+// Fills `blocks` (dims.volume() entries, BlockType values) for the given chunk.
+// With a heightfield cache the noise is shared with neighbouring chunks instead of re-evaluated.
+void generateChunkBlocks(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                         const TerrainSettings& settings, const NoiseOffset& offset,
+                         std::vector<uint8_t>& blocks, HeightfieldCache* heightfield = nullptr);
+// Same terrain into the volume's storage. Sections: sections entirely below every column's dirt layer become
+// uniform stone and those above every column's surface and water uniform air without visiting their blocks.
+// Runs: each column's layers are appended as runs straight from its height, without visiting any block.
+void generateChunkBlocks(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                         const TerrainSettings& settings, const NoiseOffset& offset,
+                         ChunkVolume& volume, HeightfieldCache* heightfield = nullptr);
+
+// Fills `padded` from the chunk's blocks; the border goes through `neighbourAt`, one call per border block
+void gatherPaddedBlocks(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                        const std::vector<uint8_t>& blocks, const BlockLookup& neighbourAt, PaddedChunkBlocks& padded);
+// Same from a neighbourhood snapshot, copying whole rows (or filling runs), and marking the sections that can't have faces
+void gatherPaddedBlocks(const ChunkDimensions& dims, const ChunkNeighbourhood& neighbourhood, PaddedChunkBlocks& padded);
+
+// Appends quads (QUAD_VERTICES each) covering every block face that borders air
+void buildChunkVertices(const PaddedChunkBlocks& padded, std::vector<PackedChunkVertex>& vertices,
+                        MeshingMode mode = MeshingMode::Naive);
+
+// Gathers the padded volume and meshes it.
+// Neighbours inside the chunk are read from `blocks`, the rest go through `neighbourAt`.
+void buildChunkVertices(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                        const std::vector<uint8_t>& blocks, const BlockLookup& neighbourAt,
+                        std::vector<PackedChunkVertex>& vertices, MeshingMode mode = MeshingMode::Naive);
+
+// Same as above with the border faces resolved from a snapshot of the neighbouring chunks. Naive meshing of a
+// Runs neighbourhood skips the padded volume: the faces come from comparing runs with the runs below, above
+// and beside them, so the work follows the run count rather than the chunk height.
+void buildChunkVertices(const std::pair<int, int>& chunk, const ChunkDimensions& dims,
+                        const ChunkNeighbourhood& neighbourhood, std::vector<PackedChunkVertex>& vertices,
+                        MeshingMode mode = MeshingMode::Naive);
+
+// Bit per face index (PackedChunkVertex::face), set for the faces whose normal points towards a directional
+// light travelling along (x, y, z). Only these can be front faces in the light's depth pass.
+uint8_t lightFacingFaces(float x, float y, float z);
+
+// Moves the faces in `faceMask` to the front of the mesh, keeping the order within both groups, and returns
+// their vertex count, so a pass that only needs those faces can draw a prefix of the mesh
+size_t groupFacesFirst(std::vector<PackedChunkVertex>& vertices, uint8_t faceMask);
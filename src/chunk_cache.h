@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <utility>
+#include "chunk_map.h"
+
+struct ChunkCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// Least-recently-used store of per-chunk values with a byte budget, for chunk data and meshes that left
+// the view but may well come back. Callers give each value's size in bytes; putting a value evicts from
+// the least recently used end until the total fits the budget again (a single value larger than the
+// budget is dropped straight away). Render thread only.
+template <typename Value>
+class ChunkCache {
+public:
+    using key_type = std::pair<int, int>;
+    using Stats = ChunkCacheStats;
+
+    explicit ChunkCache(size_t budgetBytes = 0) : budget(budgetBytes) {}
+
+    void setBudget(size_t budgetBytes) {
+        budget = budgetBytes;
+        trim();
+    }
+    size_t getBudget() const { return budget; }
+
+    // Stores the value as the most recently used, replacing any older value for the chunk
+    void put(const key_type& chunk, Value value, size_t bytes) {
+        erase(chunk);
+        order.push_front(Entry{chunk, std::move(value), bytes});
+        index.emplace(chunk, order.begin());
+        usedBytes += bytes;
+        trim();
+    }
+
+    // Moves the chunk's value out of the cache; counts a hit, or a miss when there is none
+    bool take(const key_type& chunk, Value& value) {
+        auto it = index.find(chunk);
+        if (it == index.end()) {
+            stats.misses++;
+            return false;
+        }
+        stats.hits++;
+        value = std::move(it->second->value);
+        usedBytes -= it->second->bytes;
+        order.erase(it->second);
+        index.erase(it);
+        return true;
+    }
+
+    // Marks the chunk's value as just used, if there is one
+    void touch(const key_type& chunk) {
+        auto it = index.find(chunk);
+        if (it != index.end()) {
+            order.splice(order.begin(), order, it->second);
+        }
+    }
+
+    void erase(const key_type& chunk) {
+        auto it = index.find(chunk);
+        if (it != index.end()) {
+            usedBytes -= it->second->bytes;
+            order.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    // Drops every value; the hit/miss/eviction counters keep running
+    void clear() {
+        order.clear();
+        index.clear();
+        usedBytes = 0;
+    }
+
+    Stats getStats() const {
+        Stats current = stats;
+        current.entries = index.size();
+        current.bytes = usedBytes;
+        return current;
+    }
+
+private:
+    struct Entry {
+        key_type chunk;
+        Value value;
+        size_t bytes;
+    };
+
+    void trim() {
+        while (usedBytes > budget && !order.empty()) {
+            const Entry& oldest = order.back();
+            usedBytes -= oldest.bytes;
+            index.erase(oldest.chunk);
+            order.pop_back();
+            stats.evictions++;
+        }
+    }
+
+    // Most recently used first
+    std::list<Entry> order;
+    ChunkMap<typename std::list<Entry>::iterator> index;
+    size_t budget;
+    size_t usedBytes = 0;
+    Stats stats;
+};
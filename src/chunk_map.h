@@ -0,0 +1,248 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// Hash map keyed on chunk coordinates, a drop-in for the std::map<std::pair<int, int>, T> containers.
+//
+// Entries live in one contiguous array (the "slab") and never move once inserted, so an entry's
+// Handle and pointers to it stay valid until that entry is erased. Lookup goes through a separate
+// open-addressing index (linear probing on the packed 64-bit key, at most half full, backward-shift
+// deletion so there are no tombstones). Iteration walks the slab in insertion/reuse order, NOT sorted.
+// Inserting may grow the slab and invalidate iterators (not handles), like std::vector.
+template <typename T>
+class ChunkMap {
+public:
+    using key_type = std::pair<int, int>;
+    using value_type = std::pair<key_type, T>;
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = ~Handle(0);
+
+    static uint64_t packKey(const key_type& key) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(key.first)) << 32) | static_cast<uint32_t>(key.second);
+    }
+
+    template <typename MapT, typename ValueT>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ChunkMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueT*;
+        using reference = ValueT&;
+
+        Iterator() = default;
+        // iterator -> const_iterator
+        template <typename OtherMap, typename OtherValue>
+        Iterator(const Iterator<OtherMap, OtherValue>& other) : map(other.map), index(other.index) {}
+
+        reference operator*() const { return map->entries[index]; }
+        pointer operator->() const { return &map->entries[index]; }
+        Iterator& operator++() { ++index; skipDead(); return *this; }
+        Iterator operator++(int) { Iterator old = *this; ++*this; return old; }
+        bool operator==(const Iterator& other) const { return index == other.index; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+        Handle handle() const { return static_cast<Handle>(index); }
+
+    private:
+        template <typename, typename> friend class Iterator;
+        friend class ChunkMap;
+        struct AtIndex {}; // keeps the private constructor out of brace-init overload sets like erase({0, 0})
+        Iterator(MapT* map, size_t index, AtIndex) : map(map), index(index) { skipDead(); }
+        void skipDead() {
+            while (index < map->entries.size() && !map->live[index]) ++index;
+        }
+        MapT* map = nullptr;
+        size_t index = 0;
+    };
+    using iterator = Iterator<ChunkMap, value_type>;
+    using const_iterator = Iterator<const ChunkMap, const value_type>;
+
+    iterator begin() { return iterator(this, 0, {}); }
+    iterator end() { return iterator(this, entries.size(), {}); }
+    const_iterator begin() const { return const_iterator(this, 0, {}); }
+    const_iterator end() const { return const_iterator(this, entries.size(), {}); }
+
+    size_t size() const { return liveCount; }
+    bool empty() const { return liveCount == 0; }
+
+    Handle findHandle(const key_type& key) const {
+        if (slots.empty()) return INVALID_HANDLE;
+        const uint64_t packed = packKey(key);
+        for (size_t slot = home(packed);; slot = (slot + 1) & mask()) {
+            if (slots[slot].handle == INVALID_HANDLE) return INVALID_HANDLE;
+            if (slots[slot].key == packed) return slots[slot].handle;
+        }
+    }
+    // Handles come from findHandle/emplace/iterators and stay valid until the entry is erased
+    T& at(Handle handle) { return entries[handle].second; }
+    const T& at(Handle handle) const { return entries[handle].second; }
+
+    iterator find(const key_type& key) {
+        Handle handle = findHandle(key);
+        return handle == INVALID_HANDLE ? end() : iterator(this, handle, {});
+    }
+    const_iterator find(const key_type& key) const {
+        Handle handle = findHandle(key);
+        return handle == INVALID_HANDLE ? end() : const_iterator(this, handle, {});
+    }
+    size_t count(const key_type& key) const { return findHandle(key) == INVALID_HANDLE ? 0 : 1; }
+
+    // Same contract as std::map::emplace: no-op returning the existing entry if the key is present
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(const key_type& key, Args&&... args) {
+        Handle existing = findHandle(key);
+        if (existing != INVALID_HANDLE) {
+            return {iterator(this, existing, {}), false};
+        }
+        if ((liveCount + 1) * 2 > slots.size()) {
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        }
+        Handle handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+            entries[handle] = value_type(key, T(std::forward<Args>(args)...));
+            live[handle] = 1;
+        } else {
+            handle = static_cast<Handle>(entries.size());
+            entries.emplace_back(key, T(std::forward<Args>(args)...));
+            live.push_back(1);
+        }
+        insertSlot(packKey(key), handle);
+        liveCount++;
+        return {iterator(this, handle, {}), true};
+    }
+
+    T& operator[](const key_type& key) {
+        return emplace(key).first->second;
+    }
+
+    size_t erase(const key_type& key) {
+        if (slots.empty()) return 0;
+        const uint64_t packed = packKey(key);
+        size_t slot = home(packed);
+        for (;; slot = (slot + 1) & mask()) {
+            if (slots[slot].handle == INVALID_HANDLE) return 0;
+            if (slots[slot].key == packed) break;
+        }
+        const Handle handle = slots[slot].handle;
+        // Backward-shift: pull later members of the probe run into the hole so lookups never stop early
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask(); slots[next].handle != INVALID_HANDLE; next = (next + 1) & mask()) {
+            size_t ideal = home(slots[next].key);
+            if (((next - ideal) & mask()) >= ((next - hole) & mask())) {
+                slots[hole] = slots[next];
+                hole = next;
+            }
+        }
+        slots[hole].handle = INVALID_HANDLE;
+
+        entries[handle].second = T(); // release whatever the value owns now, not when the slot is reused
+        live[handle] = 0;
+        freeHandles.push_back(handle);
+        liveCount--;
+        return 1;
+    }
+
+    // Returns the iterator following `it`, like std::map::erase
+    iterator erase(const_iterator it) {
+        size_t index = it.index;
+        erase(entries[index].first);
+        return iterator(this, index + 1, {});
+    }
+
+    // Keeps the allocated index and slab so refilling to a similar size doesn't reallocate
+    void clear() {
+        std::fill(slots.begin(), slots.end(), Slot());
+        entries.clear();
+        live.clear();
+        freeHandles.clear();
+        liveCount = 0;
+    }
+
+    void reserve(size_t n) {
+        size_t wanted = 16;
+        while (wanted < n * 2) wanted *= 2;
+        if (wanted > slots.size()) rehash(wanted);
+        entries.reserve(n);
+        live.reserve(n);
+    }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        Handle handle = INVALID_HANDLE;
+    };
+
+    size_t mask() const { return slots.size() - 1; }
+    // Fibonacci hashing: the multiply spreads both coordinates into the top bits
+    size_t home(uint64_t packed) const {
+        return static_cast<size_t>((packed * 0x9E3779B97F4A7C15ull) >> 32) & mask();
+    }
+    void insertSlot(uint64_t packed, Handle handle) {
+        size_t slot = home(packed);
+        while (slots[slot].handle != INVALID_HANDLE) slot = (slot + 1) & mask();
+        slots[slot].key = packed;
+        slots[slot].handle = handle;
+    }
+    void rehash(size_t capacity) {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(capacity, Slot());
+        for (const Slot& s : old) {
+            if (s.handle != INVALID_HANDLE) insertSlot(s.key, s.handle);
+        }
+    }
+
+    std::vector<Slot> slots;        // power-of-two open-addressing index
+    std::vector<value_type> entries; // slab, indexed by Handle
+    std::vector<uint8_t> live;
+    std::vector<Handle> freeHandles;
+    size_t liveCount = 0;
+};
+
+// Set of chunk coordinates on the same table; iterates over the keys
+class ChunkSet {
+public:
+    using key_type = std::pair<int, int>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = key_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const key_type*;
+        using reference = const key_type&;
+
+        const_iterator() = default;
+        explicit const_iterator(ChunkMap<uint8_t>::const_iterator it) : it(it) {}
+        reference operator*() const { return it->first; }
+        pointer operator->() const { return &it->first; }
+        const_iterator& operator++() { ++it; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++it; return old; }
+        bool operator==(const const_iterator& other) const { return it == other.it; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+
+    private:
+        ChunkMap<uint8_t>::const_iterator it;
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const { return const_iterator(map.begin()); }
+    const_iterator end() const { return const_iterator(map.end()); }
+    const_iterator find(const key_type& key) const { return const_iterator(map.find(key)); }
+    size_t count(const key_type& key) const { return map.count(key); }
+    size_t size() const { return map.size(); }
+    bool empty() const { return map.empty(); }
+    bool insert(const key_type& key) { return map.emplace(key, uint8_t(0)).second; }
+    size_t erase(const key_type& key) { return map.erase(key); }
+    void clear() { map.clear(); }
+    void reserve(size_t n) { map.reserve(n); }
+
+private:
+    ChunkMap<uint8_t> map;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Six clip planes pulled out of a view-projection matrix (Gribb/Hartmann), for coarse visibility tests.
+// Works for perspective and orthographic matrices alike, so it covers the camera and the shadow light.
+struct Frustum {
+    glm::vec4 planes[6]; // xyz = inward normal, w = distance; not normalised, only signs are used
+
+    static Frustum fromMatrix(const glm::mat4& m) {
+        auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+        Frustum f;
+        f.planes[0] = row(3) + row(0); // left
+        f.planes[1] = row(3) - row(0); // right
+        f.planes[2] = row(3) + row(1); // bottom
+        f.planes[3] = row(3) - row(1); // top
+        f.planes[4] = row(3) + row(2); // near
+        f.planes[5] = row(3) - row(2); // far
+        return f;
+    }
+
+    // False only when the box is entirely outside one plane (may keep a few boxes near corners)
+    bool intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+        for (const glm::vec4& p : planes) {
+            // Corner furthest along the plane normal
+            float x = p.x >= 0.0f ? boxMax.x : boxMin.x;
+            float y = p.y >= 0.0f ? boxMax.y : boxMin.y;
+            float z = p.z >= 0.0f ? boxMax.z : boxMin.z;
+            if (p.x * x + p.y * y + p.z * z + p.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,427 @@
+#include <GL/glew.h>
+#ifdef VOXEL_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "headless.h"
+#include "renderer.h"
+#include "camera.h"
+
+extern Camera camera;
+
+namespace {
+struct CameraSample {
+    float x, y, z;
+    float yaw, pitch;
+};
+
+struct FrameRecord {
+    int frame;
+    double cpuMs;   // time spent inside Renderer::render()
+    double frameMs; // render() plus glFinish(), i.e. including GPU completion
+    FrameStats stats;
+};
+
+bool endsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool loadCameraPath(const std::string& path, std::vector<CameraSample>& samples) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open camera path: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        CameraSample s;
+        if (ss >> s.x >> s.y >> s.z >> s.yaw >> s.pitch) {
+            samples.push_back(s);
+        }
+    }
+    if (samples.empty()) {
+        std::cerr << "Camera path has no samples: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Sprint across the terrain with a gentle weave and bob so chunk boundaries are crossed constantly
+CameraSample proceduralSample(float t, float speed) {
+    CameraSample s;
+    s.x = speed * t;
+    s.y = 22.0f + 4.0f * std::sin(0.5f * t);
+    s.z = 30.0f * std::sin(0.2f * t);
+    s.yaw = 25.0f * std::sin(0.3f * t);
+    s.pitch = -15.0f;
+    return s;
+}
+
+bool writeReport(const std::string& path, const std::vector<FrameRecord>& records) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to open report file: " << path << std::endl;
+        return false;
+    }
+    if (endsWith(path, ".json")) {
+        out << "{\n  \"frames\": [\n";
+        for (size_t i = 0; i < records.size(); ++i) {
+            const FrameRecord& r = records[i];
+            out << "    {\"frame\": " << r.frame
+                << ", \"cpu_ms\": " << r.cpuMs
+                << ", \"frame_ms\": " << r.frameMs
+                << ", \"chunks_generated\": " << r.stats.chunksGenerated
+                << ", \"chunks_meshed\": " << r.stats.chunksMeshed
+                << ", \"draw_calls\": " << r.stats.drawCalls
+                << ", \"vertices\": " << r.stats.verticesDrawn
+                << ", \"shadow_vertices\": " << r.stats.shadowVerticesDrawn
+                << ", \"chunks_drawn\": " << r.stats.chunksDrawn
+                << ", \"chunks_culled\": " << r.stats.chunksCulled
+                << ", \"shadow_chunks_drawn\": " << r.stats.shadowChunksDrawn
+                << ", \"shadow_chunks_culled\": " << r.stats.shadowChunksCulled
+                << ", \"shadow_update\": " << r.stats.shadowUpdate
+                << ", \"shadow_cascades_updated\": " << r.stats.shadowCascadesUpdated
+                << "}" << (i + 1 < records.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    } else {
+        out << "frame,cpu_ms,frame_ms,chunks_generated,chunks_meshed,draw_calls,vertices,shadow_vertices,"
+            << "chunks_drawn,chunks_culled,shadow_chunks_drawn,shadow_chunks_culled,shadow_update,"
+            << "shadow_cascades_updated\n";
+        for (const FrameRecord& r : records) {
+            out << r.frame << "," << r.cpuMs << "," << r.frameMs << ","
+                << r.stats.chunksGenerated << "," << r.stats.chunksMeshed << "," << r.stats.drawCalls << ","
+                << r.stats.verticesDrawn << "," << r.stats.shadowVerticesDrawn << "," << r.stats.chunksDrawn << "," << r.stats.chunksCulled << ","
+                << r.stats.shadowChunksDrawn << "," << r.stats.shadowChunksCulled << "," << r.stats.shadowUpdate << ","
+                << r.stats.shadowCascadesUpdated << "\n";
+        }
+    }
+    return true;
+}
+
+bool writeScreenshot(const std::string& path, int width, int height) {
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open screenshot file: " << path << std::endl;
+        return false;
+    }
+    out << "P6\n" << width << " " << height << "\n255\n";
+    // GL rows are bottom-up, PPM rows top-down
+    for (int y = height - 1; y >= 0; --y) {
+        out.write(reinterpret_cast<const char*>(&pixels[static_cast<size_t>(y) * width * 3]), width * 3);
+    }
+    return true;
+}
+
+void printSummary(const std::vector<FrameRecord>& records) {
+    if (records.empty()) return;
+    std::vector<double> cpu;
+    for (const FrameRecord& r : records) cpu.push_back(r.cpuMs);
+    std::sort(cpu.begin(), cpu.end());
+    auto percentile = [&](double p) {
+        return cpu[std::min(cpu.size() - 1, static_cast<size_t>(p * (cpu.size() - 1) + 0.5))];
+    };
+    double total = 0.0;
+    for (double v : cpu) total += v;
+    std::cout << "Headless run: " << records.size() << " frames, cpu ms mean " << total / cpu.size()
+              << ", p50 " << percentile(0.50) << ", p95 " << percentile(0.95)
+              << ", p99 " << percentile(0.99) << ", max " << cpu.back() << std::endl;
+    const FrameStats& last = records.back().stats;
+    std::cout << "Last frame: " << last.verticesDrawn << " vertices (" << last.shadowVerticesDrawn << " shadow), " << last.drawCalls << " draw calls, chunks drawn/culled "
+              << last.chunksDrawn << "/" << last.chunksCulled << " (main), "
+              << last.shadowChunksDrawn << "/" << last.shadowChunksCulled << " (shadow)" << std::endl;
+}
+
+void printCacheStats(const char* name, const ChunkCacheStats& stats, size_t budget) {
+    std::cout << name << ": " << stats.entries << " entries, " << stats.bytes / 1024 << "/" << budget / 1024 << " KiB, "
+              << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions" << std::endl;
+}
+
+#ifdef VOXEL_HEADLESS_EGL
+struct OffscreenContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+};
+
+// Surfaceless Mesa display first (works on llvmpipe without X/Wayland), then the default display
+bool createOffscreenContext(OffscreenContext& ctx) {
+    ctx.display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (ctx.display == EGL_NO_DISPLAY || !eglInitialize(ctx.display, nullptr, nullptr)) {
+        ctx.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (ctx.display == EGL_NO_DISPLAY || !eglInitialize(ctx.display, nullptr, nullptr)) {
+            std::cerr << "Failed to initialise an EGL display" << std::endl;
+            return false;
+        }
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL display does not support desktop OpenGL" << std::endl;
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(ctx.display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        std::cerr << "No suitable EGL config" << std::endl;
+        return false;
+    }
+
+    // Same 3.3 core profile the windowed build asks GLFW for
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    ctx.context = eglCreateContext(ctx.display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (ctx.context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL OpenGL 3.3 core context" << std::endl;
+        return false;
+    }
+
+    if (!eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx.context)) {
+        // No EGL_KHR_surfaceless_context: fall back to a tiny pbuffer, we render into our own FBO anyway
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        ctx.surface = eglCreatePbufferSurface(ctx.display, config, pbufferAttribs);
+        if (ctx.surface == EGL_NO_SURFACE || !eglMakeCurrent(ctx.display, ctx.surface, ctx.surface, ctx.context)) {
+            std::cerr << "Failed to make the EGL context current" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void destroyOffscreenContext(OffscreenContext& ctx) {
+    if (ctx.display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (ctx.surface != EGL_NO_SURFACE) eglDestroySurface(ctx.display, ctx.surface);
+    if (ctx.context != EGL_NO_CONTEXT) eglDestroyContext(ctx.display, ctx.context);
+    eglTerminate(ctx.display);
+}
+#endif
+} // namespace
+
+bool parseHeadlessOptions(int argc, char** argv, HeadlessOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless") continue;
+        if (arg == "--no-culling") {
+            options.frustumCulling = false;
+            continue;
+        }
+        if (arg == "--no-shadow-cache") {
+            options.shadowCaching = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--frames") options.frames = std::atoi(value);
+        else if (arg == "--width") options.width = std::atoi(value);
+        else if (arg == "--height") options.height = std::atoi(value);
+        else if (arg == "--speed") options.speed = std::strtof(value, nullptr);
+        else if (arg == "--path") options.pathFile = value;
+        else if (arg == "--out") options.outputFile = value;
+        else if (arg == "--screenshot") options.screenshotFile = value;
+        else if (arg == "--seed-x") options.seed.x = std::strtof(value, nullptr);
+        else if (arg == "--seed-z") options.seed.z = std::strtof(value, nullptr);
+        else if (arg == "--chunk-size") options.chunkDims.size = std::atoi(value);
+        else if (arg == "--chunk-height") options.chunkDims.height = std::atoi(value);
+        else if (arg == "--view-distance") options.viewDistance = std::atoi(value);
+        else if (arg == "--meshing") {
+            if (!parseMeshingMode(value, options.meshing)) {
+                std::cerr << "Unknown meshing mode " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--data-cache-mib") options.dataCacheMiB = std::atoi(value);
+        else if (arg == "--mesh-cache-mib") options.meshCacheMiB = std::atoi(value);
+        else if (arg == "--chunk-storage") {
+            if (!parseChunkStorage(value, options.storage)) {
+                std::cerr << "Unknown chunk storage " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--shadow-cascades") options.shadowCascades = std::atoi(value);
+        else if (arg == "--shadow-map-size") options.shadowMapSize = std::atoi(value);
+        else if (arg == "--shadow-filter") {
+            if (!parseShadowFilter(value, options.shadowFilter)) {
+                std::cerr << "Unknown shadow filter " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--draw-submission") {
+            if (!parseDrawSubmission(value, options.drawSubmission)) {
+                std::cerr << "Unknown draw submission " << value << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cerr << "Unknown headless option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.frames < 0 || options.width < 1 || options.height < 1) {
+        std::cerr << "Invalid frame count or resolution" << std::endl;
+        return false;
+    }
+    if (options.chunkDims.size < 1 || options.chunkDims.height <= options.chunkDims.waterLevel || options.viewDistance < 0) {
+        std::cerr << "Invalid chunk size/height or view distance" << std::endl;
+        return false;
+    }
+    if (options.dataCacheMiB < 0 || options.meshCacheMiB < 0) {
+        std::cerr << "Invalid cache budget" << std::endl;
+        return false;
+    }
+    if (options.shadowCascades < 1 || options.shadowCascades > Renderer::MAX_SHADOW_CASCADES || options.shadowMapSize < 1) {
+        std::cerr << "Invalid shadow cascade count (1-" << Renderer::MAX_SHADOW_CASCADES << ") or map size" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int runHeadless(const HeadlessOptions& options) {
+#ifndef VOXEL_HEADLESS_EGL
+    (void)options;
+    std::cerr << "This build has no headless support (rebuild with EGL, -DVOXEL_HEADLESS_EGL)" << std::endl;
+    return -1;
+#else
+    std::vector<CameraSample> path;
+    if (!options.pathFile.empty() && !loadCameraPath(options.pathFile, path)) {
+        return -1;
+    }
+    int frames = options.frames;
+    if (frames == 0) {
+        frames = path.empty() ? 600 : static_cast<int>(path.size());
+    }
+
+    OffscreenContext ctx;
+    if (!createOffscreenContext(ctx)) {
+        destroyOffscreenContext(ctx);
+        return -1;
+    }
+
+    glewExperimental = GL_TRUE;
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLX-flavoured GLEW complains about the missing X display but the GL entry points still load
+    if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) glewStatus = GLEW_OK;
+#endif
+    if (glewStatus != GLEW_OK) {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
+        destroyOffscreenContext(ctx);
+        return -1;
+    }
+    std::cout << "Headless GL renderer: " << glGetString(GL_RENDERER)
+              << " (" << glGetString(GL_VERSION) << ")" << std::endl;
+
+    // There is no default framebuffer, so the main pass renders into this one
+    GLuint fbo = 0, colorRbo = 0, depthRbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &colorRbo);
+    glGenRenderbuffers(1, &depthRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.width, options.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, options.width, options.height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRbo);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer not complete!" << std::endl;
+    }
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+
+    Renderer::setNoiseOffset(options.seed);
+    Renderer::setMeshingMode(options.meshing);
+    Renderer::setChunkStorage(options.storage);
+    Renderer::setCacheBudgets(static_cast<size_t>(options.dataCacheMiB) << 20, static_cast<size_t>(options.meshCacheMiB) << 20);
+    Renderer::setWorldDimensions(options.chunkDims, options.viewDistance);
+    Renderer::setFrustumCulling(options.frustumCulling);
+    Renderer::setShadowCaching(options.shadowCaching);
+    Renderer::setShadowCascades(options.shadowCascades, options.shadowMapSize);
+    Renderer::setShadowFilter(options.shadowFilter);
+    Renderer::setDrawSubmission(options.drawSubmission);
+    Renderer renderer;
+    renderer.initialise();
+    renderer.setViewportSize(options.width, options.height);
+    renderer.setTargetFramebuffer(fbo);
+
+    std::vector<FrameRecord> records;
+    records.reserve(frames);
+    for (int frame = 0; frame < frames; ++frame) {
+        CameraSample s = path.empty()
+            ? proceduralSample(frame * options.timeStep, options.speed)
+            : path[std::min(frame, static_cast<int>(path.size()) - 1)];
+        camera.Position = glm::vec3(s.x, s.y, s.z);
+        camera.SetOrientation(s.yaw, s.pitch);
+        renderer.updateVisitedChunks(renderer.getCurrentChunk(camera.Position.x, camera.Position.z));
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        auto start = std::chrono::steady_clock::now();
+        renderer.render();
+        auto cpuEnd = std::chrono::steady_clock::now();
+        glFinish();
+        auto gpuEnd = std::chrono::steady_clock::now();
+
+        FrameRecord record;
+        record.frame = frame;
+        record.cpuMs = std::chrono::duration<double, std::milli>(cpuEnd - start).count();
+        record.frameMs = std::chrono::duration<double, std::milli>(gpuEnd - start).count();
+        record.stats = renderer.getFrameStats();
+        records.push_back(record);
+    }
+
+    GLenum err;
+    while ((err = glGetError()) != GL_NO_ERROR) {
+        std::cerr << "OpenGL error during headless run: " << err << std::endl;
+    }
+
+    if (!options.screenshotFile.empty()) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        writeScreenshot(options.screenshotFile, options.width, options.height);
+    }
+
+    printSummary(records);
+    VertexArena::Stats arena = renderer.getMeshArenaStats();
+    std::cout << "Mesh arena: " << arena.pages << " page(s), " << arena.usedVertices << "/" << arena.capacityVertices
+              << " vertices in use, " << arena.freeRanges << " free ranges" << std::endl;
+    std::cout << "Chunk data: " << renderer.getChunkDataCount() << " chunks, "
+              << renderer.getChunkDataBytes() / 1024 << " KiB" << std::endl;
+    printCacheStats("Data cache", renderer.getDataCacheStats(), renderer.getDataCacheBudget());
+    printCacheStats("Mesh cache", renderer.getMeshCacheStats(), renderer.getMeshCacheBudget());
+    bool written = writeReport(options.outputFile, records);
+    if (written) {
+        std::cout << "Wrote " << records.size() << " frames to " << options.outputFile << std::endl;
+    }
+
+    renderer.cleanup();
+    glDeleteRenderbuffers(1, &colorRbo);
+    glDeleteRenderbuffers(1, &depthRbo);
+    glDeleteFramebuffers(1, &fbo);
+    destroyOffscreenContext(ctx);
+    return written ? 0 : -1;
+#endif
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include "chunk.h"
+#include "renderer.h"
+
+// Offscreen benchmark run: no window, no input, a scripted camera and machine-readable timings.
+struct HeadlessOptions {
+    // Frames to render (0 -> length of the recorded path, or 600 for the procedural flythrough)
+    int frames = 0;
+    int width = 1280;
+    int height = 720;
+    // Fixed simulation step so runs are reproducible regardless of frame time
+    float timeStep = 1.0f / 60.0f;
+    // Flythrough speed in units/second for the procedural path
+    float speed = 40.0f;
+    // Recorded path ("x y z yaw pitch" per line, one line per frame); empty -> procedural path
+    std::string pathFile;
+    // Fixed terrain seed so every run sees the same world
+    NoiseOffset seed;
+    MeshingMode meshing = MeshingMode::Naive;
+    ChunkStorage storage = ChunkStorage::Sections;
+    // Budgets of the chunk data and CPU mesh caches (0 disables)
+    int dataCacheMiB = 64;
+    int meshCacheMiB = 64;
+    // World layout (Renderer defaults: 4x32 chunks, 32 chunk view radius)
+    ChunkDimensions chunkDims = Renderer::getChunkDimensions();
+    int viewDistance = Renderer::getViewDistance();
+    bool frustumCulling = true;
+    bool shadowCaching = true;
+    // Shadow cascades and the width/height of each one's depth layer
+    int shadowCascades = Renderer::getShadowCascadeCount();
+    int shadowMapSize = Renderer::getShadowMapSize();
+    ShadowFilter shadowFilter = Renderer::getShadowFilter();
+    DrawSubmission drawSubmission = DrawSubmission::Indirect;
+    // Per-frame report; a .json extension writes JSON, anything else CSV
+    std::string outputFile = "frame_times.csv";
+    // Optional binary PPM dump of the last frame, for eyeballing or diffing output
+    std::string screenshotFile;
+};
+
+// Parses the options that follow --headless; returns false on bad input
+bool parseHeadlessOptions(int argc, char** argv, HeadlessOptions& options);
+
+// Creates an offscreen GL context, flies the global camera along the path and writes the report.
+// Returns a process exit code.
+int runHeadless(const HeadlessOptions& options);
@@ -0,0 +1,137 @@
+#include "heightfield.h"
+#include "noise.h"
+#include <algorithm>
+
+namespace {
+uint64_t tileKey(int tileX, int tileZ) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(tileX)) << 32) | static_cast<uint32_t>(tileZ);
+}
+} // namespace
+
+HeightfieldCache::HeightfieldCache(size_t maxTiles) : maxTiles(std::max<size_t>(1, maxTiles)) {}
+
+void HeightfieldCache::evaluate(int minX, int minZ, int width, int depth,
+                                const TerrainSettings& settings, const NoiseOffset& offset, float* out) {
+    const int count = width * depth;
+    std::vector<float> continentX(count), continentZ(count), detailX(count), detailZ(count);
+    std::vector<float> continent(count), detail(count);
+    for (int z = 0; z < depth; ++z) {
+        for (int x = 0; x < width; ++x) {
+            // Column centre, same point the old 9-tap kernel used for its centre tap
+            float wx = (minX + x + 0.5f) + offset.x;
+            float wz = (minZ + z + 0.5f) + offset.z;
+            int i = z * width + x;
+            continentX[i] = wx * settings.continentFreq;
+            continentZ[i] = wz * settings.continentFreq;
+            detailX[i] = wx * settings.detailFreq;
+            detailZ[i] = wz * settings.detailFreq;
+        }
+    }
+    octavePerlinBatch(continentX.data(), continentZ.data(), 0.0f, count, 4, 0.5f, continent.data());
+    octavePerlinBatch(detailX.data(), detailZ.data(), 0.0f, count, 3, 0.6f, detail.data());
+    for (int i = 0; i < count; ++i) {
+        out[i] = continent[i] * settings.continentWeight + detail[i] * settings.detailWeight;
+    }
+}
+
+bool HeightfieldCache::matchesLocked(const TerrainSettings& settings, const NoiseOffset& offset) const {
+    // Only the fields feeding the raw noise matter; smoothing and height shaping run per chunk
+    return configured
+        && cachedSettings.continentFreq == settings.continentFreq
+        && cachedSettings.detailFreq == settings.detailFreq
+        && cachedSettings.continentWeight == settings.continentWeight
+        && cachedSettings.detailWeight == settings.detailWeight
+        && cachedOffset.x == offset.x
+        && cachedOffset.z == offset.z;
+}
+
+void HeightfieldCache::evictLocked() {
+    while (tiles.size() > maxTiles) {
+        tiles.erase(order.back().key);
+        order.pop_back();
+        stats.evictions++;
+    }
+}
+
+HeightfieldCache::TilePtr HeightfieldCache::acquireTile(int tileX, int tileZ,
+                                                        const TerrainSettings& settings, const NoiseOffset& offset) {
+    const uint64_t key = tileKey(tileX, tileZ);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!matchesLocked(settings, offset)) {
+            tiles.clear();
+            order.clear();
+            cachedSettings = settings;
+            cachedOffset = offset;
+            configured = true;
+        }
+        auto it = tiles.find(key);
+        if (it != tiles.end()) {
+            order.splice(order.begin(), order, it->second);
+            stats.hits++;
+            return it->second->tile;
+        }
+        stats.misses++;
+    }
+
+    // Evaluate outside the lock so other workers keep going; if two race on the same tile the first insert wins
+    auto tile = std::make_shared<Tile>();
+    tile->values.resize(TILE_SIZE * TILE_SIZE);
+    evaluate(tileX * TILE_SIZE, tileZ * TILE_SIZE, TILE_SIZE, TILE_SIZE, settings, offset, tile->values.data());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!matchesLocked(settings, offset)) {
+        return tile; // settings changed meanwhile, hand the tile out without caching it
+    }
+    auto it = tiles.find(key);
+    if (it != tiles.end()) {
+        order.splice(order.begin(), order, it->second);
+        return it->second->tile;
+    }
+    order.push_front(Entry{key, tile});
+    tiles.emplace(key, order.begin());
+    evictLocked();
+    return tile;
+}
+
+void HeightfieldCache::sample(int minX, int minZ, int width, int depth,
+                              const TerrainSettings& settings, const NoiseOffset& offset, float* out) {
+    const int firstTileX = floorDiv(minX, TILE_SIZE);
+    const int lastTileX = floorDiv(minX + width - 1, TILE_SIZE);
+    const int firstTileZ = floorDiv(minZ, TILE_SIZE);
+    const int lastTileZ = floorDiv(minZ + depth - 1, TILE_SIZE);
+
+    for (int tileZ = firstTileZ; tileZ <= lastTileZ; ++tileZ) {
+        for (int tileX = firstTileX; tileX <= lastTileX; ++tileX) {
+            TilePtr tile = acquireTile(tileX, tileZ, settings, offset);
+            // Copy the overlap between this tile and the requested rectangle
+            const int x0 = std::max(minX, tileX * TILE_SIZE);
+            const int x1 = std::min(minX + width, (tileX + 1) * TILE_SIZE);
+            const int z0 = std::max(minZ, tileZ * TILE_SIZE);
+            const int z1 = std::min(minZ + depth, (tileZ + 1) * TILE_SIZE);
+            for (int z = z0; z < z1; ++z) {
+                const float* src = &tile->values[(z - tileZ * TILE_SIZE) * TILE_SIZE + (x0 - tileX * TILE_SIZE)];
+                std::copy(src, src + (x1 - x0), out + (z - minZ) * width + (x0 - minX));
+            }
+        }
+    }
+}
+
+void HeightfieldCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tiles.clear();
+    order.clear();
+    configured = false;
+}
+
+void HeightfieldCache::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats = Stats();
+}
+
+HeightfieldCache::Stats HeightfieldCache::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats result = stats;
+    result.tiles = tiles.size();
+    return result;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "chunk.h"
+
+// Raw (unsmoothed) terrain height noise sampled once per column centre, in square tiles shared
+// between chunks. Chunk generation reads its footprint plus a one-column apron from here and runs
+// the smoothing kernel as a 3x3 stencil over the cached grid: 7 octave evaluations per column instead of 63.
+// Safe to use from several worker threads at once.
+class HeightfieldCache {
+public:
+    static constexpr int TILE_SIZE = 16; // columns along each tile edge
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t tiles = 0;
+    };
+
+    explicit HeightfieldCache(size_t maxTiles = 1024);
+
+    // Writes the raw height noise of columns [minX, minX + width) x [minZ, minZ + depth) to
+    // out[(z - minZ) * width + (x - minX)]. Tiles built for other settings/seeds are discarded.
+    void sample(int minX, int minZ, int width, int depth,
+                const TerrainSettings& settings, const NoiseOffset& offset, float* out);
+    void clear();
+    void resetStats();
+    Stats getStats();
+
+    // Raw height noise (continent + detail blend) for a block of columns, without caching
+    static void evaluate(int minX, int minZ, int width, int depth,
+                         const TerrainSettings& settings, const NoiseOffset& offset, float* out);
+
+private:
+    struct Tile {
+        std::vector<float> values; // TILE_SIZE * TILE_SIZE, z-major
+    };
+    using TilePtr = std::shared_ptr<Tile>;
+    struct Entry {
+        uint64_t key;
+        TilePtr tile;
+    };
+
+    TilePtr acquireTile(int tileX, int tileZ, const TerrainSettings& settings, const NoiseOffset& offset);
+    bool matchesLocked(const TerrainSettings& settings, const NoiseOffset& offset) const;
+    void evictLocked();
+
+    std::mutex mutex;
+    // Most recently used first; a hit splices its entry to the front, eviction pops the back
+    std::list<Entry> order;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> tiles;
+    size_t maxTiles;
+    bool configured = false;
+    TerrainSettings cachedSettings;
+    NoiseOffset cachedOffset;
+    Stats stats;
+};
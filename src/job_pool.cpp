@@ -0,0 +1,65 @@
+#include "job_pool.h"
+
+JobPool::JobPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&JobPool::workerLoop, this);
+    }
+}
+
+JobPool::~JobPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void JobPool::submit(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void JobPool::clearPending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.clear();
+    if (running == 0) {
+        idle.notify_all();
+    }
+}
+
+void JobPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queue.empty() && running == 0; });
+}
+
+void JobPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) {
+            return;
+        }
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        ++running;
+        lock.unlock();
+        job();
+        lock.lock();
+        --running;
+        if (queue.empty() && running == 0) {
+            idle.notify_all();
+        }
+    }
+}
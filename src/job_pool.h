@@ -0,0 +1,38 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling jobs from a FIFO queue.
+// Jobs must not touch GL; results are handed back to the owner however the job sees fit.
+class JobPool {
+public:
+    using Job = std::function<void()>;
+
+    // threadCount 0 -> one worker per hardware thread, leaving one for the caller (at least 1)
+    explicit JobPool(unsigned threadCount = 0);
+    ~JobPool();
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    void submit(Job job);
+    // Drops queued jobs that have not started yet (running ones finish normally)
+    void clearPending();
+    // Blocks until the queue is empty and no job is running
+    void waitIdle();
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<Job> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    unsigned running = 0;
+    bool stopping = false;
+};
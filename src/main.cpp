@@ -1,6 +1,12 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#ifdef __APPLE__
 #include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include "imgui.h"
@@ -8,6 +14,7 @@
 #include "backends/imgui_impl_opengl3.h"
 #include "renderer.h"
 #include "camera.h"
+#include "headless.h"
 
 // Camera instance
 Camera camera;
@@ -83,6 +90,28 @@ void checkGLError(const std::string& location) {
 }
 
 int main(int argc, char** argv) {
+    // Offscreen benchmark mode: no window, GLUT or ImGui, see headless.h for the options
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            HeadlessOptions options;
+            if (!parseHeadlessOptions(argc, argv, options)) {
+                return -1;
+            }
+            return runHeadless(options);
+        }
+    }
+
+    // Optionally record the camera path ("x y z yaw pitch" per frame) for later headless replay
+    std::ofstream pathRecording;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--record-path") == 0) {
+            pathRecording.open(argv[i + 1]);
+            if (!pathRecording) {
+                std::cerr << "Failed to open camera path recording: " << argv[i + 1] << std::endl;
+            }
+        }
+    }
+
     // Initialize GLUT
     glutInit(&argc, argv);
 
@@ -180,6 +209,10 @@ int main(int argc, char** argv) {
 
         // Process input for camera movement
         camera.ProcessKeyboard(window, deltaTime);
+        if (pathRecording.is_open()) {
+            pathRecording << camera.Position.x << " " << camera.Position.y << " " << camera.Position.z << " "
+                          << camera.Yaw << " " << camera.Pitch << "\n";
+        }
 
         // Update visible chunks based on the camera position
         renderer.updateVisitedChunks(renderer.getCurrentChunk(camera.Position.x, camera.Position.z));
@@ -202,6 +235,21 @@ int main(int argc, char** argv) {
         if (ImGui::SliderFloat("Smooth center", &uiSettings.smoothingCenterWeight, 0.0f, 8.0f)) terrainDirty = true;
         if (ImGui::SliderFloat("Smooth edge", &uiSettings.smoothingEdgeWeight, 0.0f, 8.0f)) terrainDirty = true;
         if (ImGui::SliderFloat("Smooth diag", &uiSettings.smoothingDiagWeight, 0.0f, 8.0f)) terrainDirty = true;
+        // Same order as MeshingMode
+        const char* meshingModes[] = {"Naive", "Greedy", "Binary"};
+        int meshingIndex = static_cast<int>(Renderer::getMeshingMode());
+        if (ImGui::Combo("Meshing", &meshingIndex, meshingModes, IM_ARRAYSIZE(meshingModes))) {
+            Renderer::setMeshingMode(static_cast<MeshingMode>(meshingIndex));
+            renderer.clearMeshes();
+        }
+        // Same order as ChunkStorage
+        const char* chunkStorages[] = {"Sections", "Runs"};
+        int storageIndex = static_cast<int>(Renderer::getChunkStorage());
+        if (ImGui::Combo("Chunk storage", &storageIndex, chunkStorages, IM_ARRAYSIZE(chunkStorages))) {
+            Renderer::setChunkStorage(static_cast<ChunkStorage>(storageIndex));
+            renderer.clearChunksAndMeshes();
+            renderer.updateVisitedChunks(renderer.getCurrentChunk(camera.Position.x, camera.Position.z));
+        }
         if (ImGui::Button("Reseed noise")) {
             renderer.reseedNoise();
             renderer.updateVisitedChunks(renderer.getCurrentChunk(camera.Position.x, camera.Position.z));
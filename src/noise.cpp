@@ -0,0 +1,375 @@
+#include "noise.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define VOXEL_NOISE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+inline float fade(float t) {
+    return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+inline float lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+inline float grad(int hash, float x, float y, float z) {
+    int h = hash & 15;
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+// Doubled permutation table; function-local static so it is built exactly once, even with worker threads calling in
+const int* permutationTable() {
+    static const int permutation[] = { 151,160,137,91,90,15,
+    131,13,201,95,96,53,194,233,7,225,140,36,103,30,
+    69,142,8,99,37,240,21,10,23,190, 6,148,247,120,
+    234,75,0,26,197,62,94,252,219,203,117,35,11,32,
+    57,177,33,88,237,149,56,87,174,20,125,136,171,
+    168, 68,175,74,165,71,134,139,48,27,166,77,146,
+    158,231,83,111,229,122,60,211,133,230,220,105,
+    92,41,55,46,245,40,244,102,143,54, 65,25,63,161,
+    1,216,80,73,209,76,132,187,208,89,18,169,200,
+    196,135,130,116,188,159,86,164,100,109,198,173,
+    186, 3,64,52,217,226,250,124,123,5,202,38,147,
+    118,126,255,82,85,212,207,206,59,227,47,16,58,
+    17,182,189,28,42,223,183,170,213,119,248,152,
+    2,44,154,163,70,221,153,101,155,167,43,172,9,
+    129,22,39,253, 19,98,108,110,79,113,224,232,178,
+    185, 112,104,218,246,97,228,251,34,242,193,238,
+    210,144,12,191,179,162,241,81,51,145,235,249,
+    14,239,107,49,192,214,31,181,199,106,157,184,
+    84,204,176,115,121,50,45,127, 4,150,254,138,
+    236,205,93,222,114,67,29,24,72,243,141,128,195,
+    78,66,215,61,156,180 };
+
+    struct PermutationTable {
+        int p[512];
+        PermutationTable() {
+            for (int i = 0; i < 256; ++i) {
+                p[256 + i] = p[i] = permutation[i];
+            }
+        }
+    };
+    static const PermutationTable table;
+    return table.p;
+}
+
+// Row kernels: out[i] = perlin(xs[i], ys[i], z). The SIMD versions perform exactly the scalar
+// operations in the same order (no FMA, same lerp argument order), so results are bit-identical.
+void perlinRowScalar(const float* xs, const float* ys, float z, int count, float* out) {
+    for (int i = 0; i < count; ++i) {
+        out[i] = perlin(xs[i], ys[i], z);
+    }
+}
+
+#ifdef VOXEL_NOISE_X86
+__attribute__((target("sse4.1")))
+inline __m128 fade4(__m128 t) {
+    __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+}
+
+__attribute__((target("sse4.1")))
+inline __m128 lerp4(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+__attribute__((target("sse4.1")))
+inline __m128 grad4(__m128i hash, __m128 x, __m128 y, __m128 z) {
+    __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+    __m128 u = _mm_blendv_ps(y, x, _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8))));
+    __m128i is12or14 = _mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14)));
+    __m128 v = _mm_blendv_ps(z, x, _mm_castsi128_ps(is12or14));
+    v = _mm_blendv_ps(v, y, _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4))));
+    // Negation by flipping the sign bit, exactly like unary minus
+    __m128 uSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    __m128 vSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    return _mm_add_ps(_mm_xor_ps(u, uSign), _mm_xor_ps(v, vSign));
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i load4(const int* values) {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(values));
+}
+
+__attribute__((target("sse4.1")))
+void perlinRowSse41(const float* xs, const float* ys, float z, int count, float* out) {
+    const int* p = permutationTable();
+    const int Z = static_cast<int>(std::floor(z)) & 255;
+    const float zf = z - std::floor(z);
+    const __m128 zv = _mm_set1_ps(zf);
+    const __m128 zv1 = _mm_set1_ps(zf - 1);
+    const __m128 w = _mm_set1_ps(fade(zf));
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 y = _mm_loadu_ps(ys + i);
+        __m128 fx = _mm_floor_ps(x);
+        __m128 fy = _mm_floor_ps(y);
+        alignas(16) int X[4], Y[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(X), _mm_and_si128(_mm_cvttps_epi32(fx), _mm_set1_epi32(255)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(Y), _mm_and_si128(_mm_cvttps_epi32(fy), _mm_set1_epi32(255)));
+        x = _mm_sub_ps(x, fx);
+        y = _mm_sub_ps(y, fy);
+
+        // No gather before AVX2: hash the corners per lane
+        alignas(16) int hAA[4], hBA[4], hAB[4], hBB[4], hAA1[4], hBA1[4], hAB1[4], hBB1[4];
+        for (int lane = 0; lane < 4; ++lane) {
+            int A = p[X[lane]] + Y[lane], AA = p[A] + Z, AB = p[A + 1] + Z;
+            int B = p[X[lane] + 1] + Y[lane], BA = p[B] + Z, BB = p[B + 1] + Z;
+            hAA[lane] = p[AA]; hBA[lane] = p[BA]; hAB[lane] = p[AB]; hBB[lane] = p[BB];
+            hAA1[lane] = p[AA + 1]; hBA1[lane] = p[BA + 1]; hAB1[lane] = p[AB + 1]; hBB1[lane] = p[BB + 1];
+        }
+
+        __m128 u = fade4(x);
+        __m128 v = fade4(y);
+        __m128 x1 = _mm_sub_ps(x, one);
+        __m128 y1 = _mm_sub_ps(y, one);
+
+        __m128 res = lerp4(w, lerp4(v, lerp4(u, grad4(load4(hAA), x, y, zv),
+                                                grad4(load4(hBA), x1, y, zv)),
+                                       lerp4(u, grad4(load4(hAB), x, y1, zv),
+                                                grad4(load4(hBB), x1, y1, zv))),
+                              lerp4(v, lerp4(u, grad4(load4(hAA1), x, y, zv1),
+                                                grad4(load4(hBA1), x1, y, zv1)),
+                                       lerp4(u, grad4(load4(hAB1), x, y1, zv1),
+                                                grad4(load4(hBB1), x1, y1, zv1))));
+        _mm_storeu_ps(out + i, res);
+    }
+    perlinRowScalar(xs + i, ys + i, z, count - i, out + i);
+}
+
+__attribute__((target("avx2")))
+inline __m256 fade8(__m256 t) {
+    __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+}
+
+__attribute__((target("avx2")))
+inline __m256 lerp8(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+__attribute__((target("avx2")))
+inline __m256 grad8(__m256i hash, __m256 x, __m256 y, __m256 z) {
+    __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+    __m256 u = _mm256_blendv_ps(y, x, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h)));
+    __m256i is12or14 = _mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14)));
+    __m256 v = _mm256_blendv_ps(z, x, _mm256_castsi256_ps(is12or14));
+    v = _mm256_blendv_ps(v, y, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h)));
+    __m256 uSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+    __m256 vSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+    return _mm256_add_ps(_mm256_xor_ps(u, uSign), _mm256_xor_ps(v, vSign));
+}
+
+__attribute__((target("avx2")))
+inline __m256i gather8(const int* p, __m256i index) {
+    return _mm256_i32gather_epi32(p, index, 4);
+}
+
+__attribute__((target("avx2")))
+void perlinRowAvx2(const float* xs, const float* ys, float z, int count, float* out) {
+    const int* p = permutationTable();
+    const __m256i Z = _mm256_set1_epi32(static_cast<int>(std::floor(z)) & 255);
+    const float zf = z - std::floor(z);
+    const __m256 zv = _mm256_set1_ps(zf);
+    const __m256 zv1 = _mm256_set1_ps(zf - 1);
+    const __m256 w = _mm256_set1_ps(fade(zf));
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i oneI = _mm256_set1_epi32(1);
+    const __m256i mask = _mm256_set1_epi32(255);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+        __m256 fx = _mm256_floor_ps(x);
+        __m256 fy = _mm256_floor_ps(y);
+        __m256i X = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+        __m256i Y = _mm256_and_si256(_mm256_cvttps_epi32(fy), mask);
+        x = _mm256_sub_ps(x, fx);
+        y = _mm256_sub_ps(y, fy);
+
+        __m256i A = _mm256_add_epi32(gather8(p, X), Y);
+        __m256i AA = _mm256_add_epi32(gather8(p, A), Z);
+        __m256i AB = _mm256_add_epi32(gather8(p, _mm256_add_epi32(A, oneI)), Z);
+        __m256i B = _mm256_add_epi32(gather8(p, _mm256_add_epi32(X, oneI)), Y);
+        __m256i BA = _mm256_add_epi32(gather8(p, B), Z);
+        __m256i BB = _mm256_add_epi32(gather8(p, _mm256_add_epi32(B, oneI)), Z);
+
+        __m256 u = fade8(x);
+        __m256 v = fade8(y);
+        __m256 x1 = _mm256_sub_ps(x, one);
+        __m256 y1 = _mm256_sub_ps(y, one);
+
+        __m256 res = lerp8(w, lerp8(v, lerp8(u, grad8(gather8(p, AA), x, y, zv),
+                                                grad8(gather8(p, BA), x1, y, zv)),
+                                       lerp8(u, grad8(gather8(p, AB), x, y1, zv),
+                                                grad8(gather8(p, BB), x1, y1, zv))),
+                              lerp8(v, lerp8(u, grad8(gather8(p, _mm256_add_epi32(AA, oneI)), x, y, zv1),
+                                                grad8(gather8(p, _mm256_add_epi32(BA, oneI)), x1, y, zv1)),
+                                       lerp8(u, grad8(gather8(p, _mm256_add_epi32(AB, oneI)), x, y1, zv1),
+                                                grad8(gather8(p, _mm256_add_epi32(BB, oneI)), x1, y1, zv1))));
+        _mm256_storeu_ps(out + i, res);
+    }
+    perlinRowScalar(xs + i, ys + i, z, count - i, out + i);
+}
+#endif
+
+using PerlinRowKernel = void (*)(const float*, const float*, float, int, float*);
+
+bool kernelSupported(NoiseKernel kernel) {
+    switch (kernel) {
+        case NoiseKernel::Scalar: return true;
+#ifdef VOXEL_NOISE_X86
+        case NoiseKernel::Sse41: return __builtin_cpu_supports("sse4.1");
+        case NoiseKernel::Avx2: return __builtin_cpu_supports("avx2");
+#endif
+        default: return false;
+    }
+}
+
+// Best supported kernel, unless VOXEL_NOISE_KERNEL=scalar|sse41|avx2 asks for a specific one
+NoiseKernel detectNoiseKernel() {
+    if (const char* forced = std::getenv("VOXEL_NOISE_KERNEL")) {
+        const NoiseKernel kernels[] = {NoiseKernel::Scalar, NoiseKernel::Sse41, NoiseKernel::Avx2};
+        for (NoiseKernel kernel : kernels) {
+            if (std::strcmp(forced, noiseKernelName(kernel)) == 0 && kernelSupported(kernel)) {
+                return kernel;
+            }
+        }
+    }
+    if (kernelSupported(NoiseKernel::Avx2)) return NoiseKernel::Avx2;
+    if (kernelSupported(NoiseKernel::Sse41)) return NoiseKernel::Sse41;
+    return NoiseKernel::Scalar;
+}
+
+// Atomic so setNoiseKernel can switch kernels while generation workers are reading it; every kernel returns
+// the same values, so which one a batch in flight picks doesn't matter
+std::atomic<NoiseKernel>& activeKernel() {
+    static std::atomic<NoiseKernel> kernel{detectNoiseKernel()};
+    return kernel;
+}
+
+PerlinRowKernel rowKernel(NoiseKernel kernel) {
+    switch (kernel) {
+#ifdef VOXEL_NOISE_X86
+        case NoiseKernel::Sse41: return perlinRowSse41;
+        case NoiseKernel::Avx2: return perlinRowAvx2;
+#endif
+        default: return perlinRowScalar;
+    }
+}
+} // namespace
+
+float perlin(float x, float y, float z) {
+    const int* p = permutationTable();
+
+    int X = static_cast<int>(std::floor(x)) & 255;
+    int Y = static_cast<int>(std::floor(y)) & 255;
+    int Z = static_cast<int>(std::floor(z)) & 255;
+
+    x -= std::floor(x);
+    y -= std::floor(y);
+    z -= std::floor(z);
+
+    float u = fade(x);
+    float v = fade(y);
+    float w = fade(z);
+
+    int A = p[X] + Y, AA = p[A] + Z, AB = p[A + 1] + Z;
+    int B = p[X + 1] + Y, BA = p[B] + Z, BB = p[B + 1] + Z;
+
+    float res = lerp(w, lerp(v, lerp(u, grad(p[AA], x, y, z),
+                                    grad(p[BA], x - 1, y, z)),
+                                lerp(u, grad(p[AB], x, y - 1, z),
+                                    grad(p[BB], x - 1, y - 1, z))),
+                        lerp(v, lerp(u, grad(p[AA + 1], x, y, z - 1),
+                                    grad(p[BA + 1], x - 1, y, z - 1)),
+                                lerp(u, grad(p[AB + 1], x, y - 1, z - 1),
+                                    grad(p[BB + 1], x - 1, y - 1, z - 1))));
+    return res;
+}
+
+float octavePerlin(float x, float y, float z, int octaves, float persistence) {
+    float total = 0.0f;
+    float frequency = 1.0f;
+    float amplitude = 1.0f;
+    float maxValue = 0.0f;
+
+    for (int i = 0; i < octaves; ++i) {
+        total += perlin(x * frequency, y * frequency, z * frequency) * amplitude;
+        maxValue += amplitude;
+        amplitude *= persistence;
+        frequency *= 2.0f;
+    }
+
+    return total / maxValue;
+}
+
+const char* noiseKernelName(NoiseKernel kernel) {
+    switch (kernel) {
+        case NoiseKernel::Sse41: return "sse41";
+        case NoiseKernel::Avx2: return "avx2";
+        case NoiseKernel::Scalar:
+        default: return "scalar";
+    }
+}
+
+NoiseKernel getNoiseKernel() {
+    return activeKernel().load(std::memory_order_relaxed);
+}
+
+bool setNoiseKernel(NoiseKernel kernel) {
+    if (!kernelSupported(kernel)) {
+        return false;
+    }
+    activeKernel().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+void perlinBatch(const float* xs, const float* ys, float z, int count, float* out) {
+    rowKernel(activeKernel().load(std::memory_order_relaxed))(xs, ys, z, count, out);
+}
+
+void octavePerlinBatch(const float* xs, const float* ys, float z, int count, int octaves, float persistence, float* out) {
+    // Work in fixed-size blocks so the scaled coordinates stay on the stack
+    constexpr int BLOCK = 64;
+    const PerlinRowKernel kernel = rowKernel(activeKernel().load(std::memory_order_relaxed));
+    float sx[BLOCK], sy[BLOCK], sample[BLOCK], total[BLOCK];
+
+    for (int start = 0; start < count; start += BLOCK) {
+        const int n = count - start < BLOCK ? count - start : BLOCK;
+        float frequency = 1.0f;
+        float amplitude = 1.0f;
+        float maxValue = 0.0f;
+        for (int i = 0; i < n; ++i) total[i] = 0.0f;
+
+        for (int octave = 0; octave < octaves; ++octave) {
+            for (int i = 0; i < n; ++i) {
+                sx[i] = xs[start + i] * frequency;
+                sy[i] = ys[start + i] * frequency;
+            }
+            kernel(sx, sy, z * frequency, n, sample);
+            for (int i = 0; i < n; ++i) {
+                total[i] += sample[i] * amplitude;
+            }
+            maxValue += amplitude;
+            amplitude *= persistence;
+            frequency *= 2.0f;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            out[start + i] = total[i] / maxValue;
+        }
+    }
+}
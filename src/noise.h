@@ -0,0 +1,26 @@
+#pragma once
+
+// Classic 3D Perlin noise, roughly in [-1, 1]
+float perlin(float x, float y, float z);
+
+// Sum of `octaves` Perlin layers, each at double the frequency and `persistence` times the amplitude
+float octavePerlin(float x, float y, float z, int octaves, float persistence);
+
+// Implementations behind the batched API, picked at runtime from what the CPU supports.
+// All of them return exactly the same values as perlin()/octavePerlin().
+enum class NoiseKernel {
+    Scalar,
+    Sse41,
+    Avx2
+};
+
+const char* noiseKernelName(NoiseKernel kernel);
+NoiseKernel getNoiseKernel();
+// Returns false (and keeps the current kernel) if the CPU can't run the requested one
+bool setNoiseKernel(NoiseKernel kernel);
+
+// out[i] = perlin(xs[i], ys[i], z) for a row/tile of points sharing the same z
+void perlinBatch(const float* xs, const float* ys, float z, int count, float* out);
+
+// out[i] = octavePerlin(xs[i], ys[i], z, octaves, persistence)
+void octavePerlinBatch(const float* xs, const float* ys, float z, int count, int octaves, float persistence, float* out);
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <set>
+#include <utility>
+
+// Sub-allocator for a fixed-capacity linear range (units are whatever the caller counts in, e.g. vertices).
+// Best-fit over a free list kept twice: by offset, so freed ranges coalesce with their neighbours,
+// and by (size, offset), so allocation is a single lower_bound. GL-free; VertexArena puts GPU buffers behind it.
+class RangeAllocator {
+public:
+    static constexpr uint32_t INVALID_OFFSET = ~uint32_t(0);
+
+    explicit RangeAllocator(uint32_t capacity = 0) { reset(capacity); }
+
+    // Forgets every allocation and makes [0, capacity) one free range
+    void reset(uint32_t newCapacity) {
+        capacity = newCapacity;
+        used = 0;
+        byOffset.clear();
+        bySize.clear();
+        if (capacity > 0) insertFree(0, capacity);
+    }
+
+    // Offset of a free range of exactly `size` units, or INVALID_OFFSET if no single range is big enough
+    uint32_t allocate(uint32_t size) {
+        if (size == 0) return INVALID_OFFSET;
+        auto fit = bySize.lower_bound({size, 0});
+        if (fit == bySize.end()) return INVALID_OFFSET;
+        const uint32_t rangeSize = fit->first;
+        const uint32_t offset = fit->second;
+        eraseFree(offset, rangeSize);
+        if (rangeSize > size) insertFree(offset + size, rangeSize - size);
+        used += size;
+        return offset;
+    }
+
+    // Returns [offset, offset + size) from an earlier allocate(size)
+    void free(uint32_t offset, uint32_t size) {
+        if (size == 0) return;
+        used -= size;
+        uint32_t start = offset;
+        uint32_t end = offset + size;
+        auto next = byOffset.lower_bound(offset);
+        if (next != byOffset.end() && next->first == end) {
+            end += next->second;
+            eraseFree(next->first, next->second);
+            next = byOffset.lower_bound(offset);
+        }
+        if (next != byOffset.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == start) {
+                start = prev->first;
+                eraseFree(prev->first, prev->second);
+            }
+        }
+        insertFree(start, end - start);
+    }
+
+    uint32_t getCapacity() const { return capacity; }
+    uint32_t getUsed() const { return used; }
+    size_t freeRangeCount() const { return byOffset.size(); }
+    // Largest single allocation that would currently succeed
+    uint32_t largestFreeRange() const { return bySize.empty() ? 0 : bySize.rbegin()->first; }
+
+private:
+    void insertFree(uint32_t offset, uint32_t size) {
+        byOffset.emplace(offset, size);
+        bySize.emplace(size, offset);
+    }
+    void eraseFree(uint32_t offset, uint32_t size) {
+        byOffset.erase(offset);
+        bySize.erase({size, offset});
+    }
+
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+    std::map<uint32_t, uint32_t> byOffset;          // offset -> size
+    std::set<std::pair<uint32_t, uint32_t>> bySize; // (size, offset)
+};
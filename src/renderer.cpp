@@ -1,7 +1,9 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include <GL/glew.h>
+#ifdef __APPLE__
 #include <OpenGL/gl.h>
+#endif
 #include <GLFW/glfw3.h>
 #include <fstream>
 #include <sstream>
@@ -11,127 +13,130 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "camera.h"
+#include "frustum.h"
 #include <set>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <cmath>
 #include <map>
 #include <algorithm>
 #include <random>
+#include <iterator>
 
-// Chunk/world configuration
-constexpr int CHUNK_SIZE = 4;
-constexpr int CHUNK_HEIGHT = 32;
-constexpr int VIEW_DISTANCE = 32;
-constexpr int WATER_LEVEL = 10;
-constexpr int MAX_CHUNK_BUILDS_PER_FRAME = 32;
+// Chunk/world configuration (chunk dimensions and view distance are Renderer::setWorldDimensions)
+constexpr int MAX_CHUNK_UPLOADS_PER_FRAME = 32;
+// Meshes and data stay loaded this many rings past where they are needed before going to the caches,
+// so moving back and forth across a chunk border doesn't drop and reload the same strips
+constexpr int CACHE_KEEP_RINGS = 2;
 constexpr bool DRAW_WIREFRAME = false;
-constexpr int SHADOW_MAP_SIZE = 4096;
+// Camera projection; shadows reach as far as the loaded chunks, split into cascades by shadowCascadeCount
+constexpr float CAMERA_FOV_DEGREES = 45.0f;
+constexpr float CAMERA_NEAR = 0.1f;
+constexpr float CAMERA_FAR = 2000.0f;
+// Weight of the logarithmic split against the uniform one when placing cascade boundaries
+constexpr float SHADOW_SPLIT_BLEND = 0.5f;
+// How far each cascade's light volume reaches towards the light past its slice, for casters outside the view
+constexpr float SHADOW_CASTER_MARGIN = 50.0f;
+// Direction the sunlight travels (normalised in render()); meshes are built with the faces facing it first
+constexpr float LIGHT_DIRECTION[3] = {-0.5f, -1.2f, -0.3f};
 
 TerrainSettings Renderer::terrainSettings = TerrainSettings{};
-
-enum class BlockType : uint8_t {
-    Air = 0,
-    Grass,
-    Dirt,
-    Stone,
-    Water
-};
+MeshingMode Renderer::meshingMode = MeshingMode::Naive;
+ChunkStorage Renderer::chunkStorage = ChunkStorage::Sections;
+size_t Renderer::dataCacheBudget = size_t(64) << 20;
+size_t Renderer::meshCacheBudget = size_t(64) << 20;
+ChunkDimensions Renderer::chunkDims = ChunkDimensions{4, 32, 10};
+int Renderer::viewDistance = 32;
+bool Renderer::frustumCulling = true;
+bool Renderer::shadowCaching = true;
+int Renderer::shadowCascadeCount = 3;
+int Renderer::shadowMapSize = 2048;
+ShadowFilter Renderer::shadowFilter = ShadowFilter::Pcf5x5;
+DrawSubmission Renderer::drawSubmission = DrawSubmission::Indirect;
+
+// Texture unit of the chunk origin buffer texture (the shadow map is on 0)
+constexpr int CHUNK_ORIGINS_UNIT = 1;
+
+// Binding point of the FrameUniforms block
+constexpr unsigned int FRAME_UNIFORMS_BINDING = 0;
 
 namespace {
-inline float fade(float t) {
-    return t * t * t * (t * (t * 6 - 15) + 10);
-}
-
-inline float lerp(float a, float b, float t) {
-    return a + t * (b - a);
-}
-
-inline float grad(int hash, float x, float y, float z) {
-    int h = hash & 15;
-    float u = h < 8 ? x : y;
-    float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
-    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
-}
-
-float perlin(float x, float y, float z) {
-    static const int permutation[] = { 151,160,137,91,90,15,
-    131,13,201,95,96,53,194,233,7,225,140,36,103,30,
-    69,142,8,99,37,240,21,10,23,190, 6,148,247,120,
-    234,75,0,26,197,62,94,252,219,203,117,35,11,32,
-    57,177,33,88,237,149,56,87,174,20,125,136,171,
-    168, 68,175,74,165,71,134,139,48,27,166,77,146,
-    158,231,83,111,229,122,60,211,133,230,220,105,
-    92,41,55,46,245,40,244,102,143,54, 65,25,63,161,
-    1,216,80,73,209,76,132,187,208,89,18,169,200,
-    196,135,130,116,188,159,86,164,100,109,198,173,
-    186, 3,64,52,217,226,250,124,123,5,202,38,147,
-    118,126,255,82,85,212,207,206,59,227,47,16,58,
-    17,182,189,28,42,223,183,170,213,119,248,152,
-    2,44,154,163,70,221,153,101,155,167,43,172,9,
-    129,22,39,253, 19,98,108,110,79,113,224,232,178,
-    185, 112,104,218,246,97,228,251,34,242,193,238,
-    210,144,12,191,179,162,241,81,51,145,235,249,
-    14,239,107,49,192,214,31,181,199,106,157,184,
-    84,204,176,115,121,50,45,127, 4,150,254,138,
-    236,205,93,222,114,67,29,24,72,243,141,128,195,
-    78,66,215,61,156,180 };
-
-    static int p[512];
-    static bool initialized = false;
-    if (!initialized) {
-        for (int i = 0; i < 256; ++i) {
-            p[256 + i] = p[i] = permutation[i];
-        }
-        initialized = true;
-    }
-
-    int X = static_cast<int>(std::floor(x)) & 255;
-    int Y = static_cast<int>(std::floor(y)) & 255;
-    int Z = static_cast<int>(std::floor(z)) & 255;
+// Mirrors the std140 FrameUniforms block in the shaders: vec3/vec2 members are padded to vec4
+struct FrameUniformBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 cascadeLightSpace[Renderer::MAX_SHADOW_CASCADES];
+    glm::vec4 cascadeSplits;
+    glm::vec4 cascadeTexelDepth;
+    glm::vec4 lightDir;
+    glm::vec4 lightColor;
+    glm::vec4 ambientColor;
+    glm::vec4 shadowTexelSize;
+};
+static_assert(sizeof(FrameUniformBlock) == 480, "FrameUniformBlock must match the std140 layout");
 
-    x -= std::floor(x);
-    y -= std::floor(y);
-    z -= std::floor(z);
+// Run-time seed to randomize terrain each launch
+NoiseOffset noiseOffset;
+bool noiseSeeded = false;
 
-    float u = fade(x);
-    float v = fade(y);
-    float w = fade(z);
+// Packed vertex positions are chunk-local block corners; corner (0, 0, 0) of a chunk sits here in world space
+glm::vec3 chunkOrigin(const std::pair<int, int>& chunk, int chunkSize) {
+    return glm::vec3(chunk.first * chunkSize - 0.5f, -0.5f, chunk.second * chunkSize - 0.5f);
+}
 
-    int A = p[X] + Y, AA = p[A] + Z, AB = p[A + 1] + Z;
-    int B = p[X + 1] + Y, BA = p[B] + Z, BB = p[B + 1] + Z;
+// Smallest sphere around the slice of the view frustum between view depths `nearZ` and `farZ`, as a
+// distance along the view direction and a radius. Only the projection goes in, so turning the camera
+// keeps the radius (and the cascade's texel size) exactly the same.
+struct CascadeSphere {
+    float centreDepth;
+    float radius;
+};
 
-    float res = lerp(w, lerp(v, lerp(u, grad(p[AA], x, y, z),
-                                    grad(p[BA], x - 1, y, z)),
-                                lerp(u, grad(p[AB], x, y - 1, z),
-                                    grad(p[BB], x - 1, y - 1, z))),
-                        lerp(v, lerp(u, grad(p[AA + 1], x, y, z - 1),
-                                    grad(p[BA + 1], x - 1, y, z - 1)),
-                                lerp(u, grad(p[AB + 1], x, y - 1, z - 1),
-                                    grad(p[BB + 1], x - 1, y - 1, z - 1))));
-    return res;
+CascadeSphere fitCascadeSphere(float nearZ, float farZ, float tanHalfFovY, float aspect) {
+    // Squared slope of the slice's corner edges; the centre is equidistant from near and far corners
+    // unless that falls past the far plane, where the far corners alone decide
+    const float k2 = tanHalfFovY * tanHalfFovY * (1.0f + aspect * aspect);
+    const float centre = std::min(farZ, 0.5f * (nearZ + farZ) * (1.0f + k2));
+    const float radius = std::sqrt(std::max((centre - nearZ) * (centre - nearZ) + nearZ * nearZ * k2,
+                                            (farZ - centre) * (farZ - centre) + farZ * farZ * k2));
+    return CascadeSphere{centre, radius};
 }
 
-float octavePerlin(float x, float y, float z, int octaves, float persistence) {
-    float total = 0.0f;
-    float frequency = 1.0f;
-    float amplitude = 1.0f;
-    float maxValue = 0.0f;
+// Light view-projection for a cascade of half-width `radius` around `centre`. The centre is snapped to
+// whole texels of the cascade's layer in light space (depth too), so the layer only ever shifts by whole
+// texels and a camera that hasn't moved a texel gives a bit-identical matrix, which is what lets render()
+// reuse the previous depth pass.
+glm::mat4 snappedLightSpace(const glm::vec3& centre, const glm::vec3& lightDir, float radius, int mapSize) {
+    const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDir, glm::vec3(0.0f, 1.0f, 0.0f));
+    const float texel = 2.0f * radius / static_cast<float>(mapSize);
+    const glm::vec3 snapped = glm::floor(glm::vec3(lightRotation * glm::vec4(centre, 1.0f)) / texel) * texel;
+    // Eye radius + SHADOW_CASTER_MARGIN back along the light from the snapped centre (the light looks down -z)
+    const float eyeDistance = radius + SHADOW_CASTER_MARGIN;
+    glm::mat4 lightView = lightRotation;
+    lightView[3] = glm::vec4(-snapped.x, -snapped.y, -snapped.z - eyeDistance, 1.0f);
+    const glm::mat4 lightProj = glm::ortho(-radius, radius, -radius, radius, 0.0f, eyeDistance + radius);
+    return lightProj * lightView;
+}
 
-    for (int i = 0; i < octaves; ++i) {
-        total += perlin(x * frequency, y * frequency, z * frequency) * amplitude;
-        maxValue += amplitude;
-        amplitude *= persistence;
-        frequency *= 2.0f;
+// Calls fn for every chunk within `radius` of `center` that is not within `radius` of `other`
+// (all of them when `other` is not valid). Walks only the strips that differ, not the whole square.
+template <typename Fn>
+void forEachRingDelta(const std::pair<int, int>& center, const std::pair<int, int>& other, bool otherValid,
+                      int radius, Fn&& fn) {
+    const int minZ = center.second - radius;
+    const int maxZ = center.second + radius;
+    for (int x = center.first - radius; x <= center.first + radius; ++x) {
+        if (!otherValid || std::abs(x - other.first) > radius) {
+            for (int z = minZ; z <= maxZ; ++z) fn(std::make_pair(x, z));
+            continue;
+        }
+        // Column overlaps the other square: only the z ranges below and above it are new
+        for (int z = minZ; z <= std::min(maxZ, other.second - radius - 1); ++z) fn(std::make_pair(x, z));
+        for (int z = std::max(minZ, other.second + radius + 1); z <= maxZ; ++z) fn(std::make_pair(x, z));
     }
-
-    return total / maxValue;
 }
-
-// Run-time seed to randomize terrain each launch
-float noiseOffsetX = 0.0f;
-float noiseOffsetZ = 0.0f;
-bool noiseSeeded = false;
 } // namespace
 
 void Renderer::setTerrainSettings(const TerrainSettings& settings) {
@@ -142,27 +147,167 @@ TerrainSettings Renderer::getTerrainSettings() {
     return terrainSettings;
 }
 
+void Renderer::setNoiseOffset(const NoiseOffset& offset) {
+    noiseOffset = offset;
+    noiseSeeded = true;
+}
+
+void Renderer::setWorldDimensions(const ChunkDimensions& dims, int distance) {
+    chunkDims = dims;
+    viewDistance = distance;
+}
+
+ChunkDimensions Renderer::getChunkDimensions() {
+    return chunkDims;
+}
+
+int Renderer::getViewDistance() {
+    return viewDistance;
+}
+
+void Renderer::setMeshingMode(MeshingMode mode) {
+    meshingMode = mode;
+}
+
+MeshingMode Renderer::getMeshingMode() {
+    return meshingMode;
+}
+
+void Renderer::setChunkStorage(ChunkStorage storage) {
+    chunkStorage = storage;
+}
+
+ChunkStorage Renderer::getChunkStorage() {
+    return chunkStorage;
+}
+
+void Renderer::setCacheBudgets(size_t dataBytes, size_t meshBytes) {
+    dataCacheBudget = dataBytes;
+    meshCacheBudget = meshBytes;
+}
+
+void Renderer::setFrustumCulling(bool enabled) {
+    frustumCulling = enabled;
+}
+
+void Renderer::setShadowCaching(bool enabled) {
+    shadowCaching = enabled;
+}
+
+void Renderer::setShadowCascades(int count, int mapSize) {
+    shadowCascadeCount = std::min(std::max(count, 1), MAX_SHADOW_CASCADES);
+    shadowMapSize = std::max(mapSize, 1);
+}
+
+int Renderer::getShadowCascadeCount() {
+    return shadowCascadeCount;
+}
+
+int Renderer::getShadowMapSize() {
+    return shadowMapSize;
+}
+
+void Renderer::setShadowFilter(ShadowFilter filter) {
+    shadowFilter = filter;
+}
+
+ShadowFilter Renderer::getShadowFilter() {
+    return shadowFilter;
+}
+
+void Renderer::setDrawSubmission(DrawSubmission submission) {
+    drawSubmission = submission;
+}
+
+DrawSubmission Renderer::getDrawSubmission() {
+    return drawSubmission;
+}
+
+const char* drawSubmissionName(DrawSubmission submission) {
+    switch (submission) {
+    case DrawSubmission::PerChunk: return "per-chunk";
+    case DrawSubmission::MultiDraw: return "multi-draw";
+    case DrawSubmission::Indirect: return "indirect";
+    }
+    return "unknown";
+}
+
+bool parseDrawSubmission(const char* name, DrawSubmission& submission) {
+    const DrawSubmission all[] = {DrawSubmission::PerChunk, DrawSubmission::MultiDraw, DrawSubmission::Indirect};
+    for (DrawSubmission candidate : all) {
+        if (std::strcmp(name, drawSubmissionName(candidate)) == 0) {
+            submission = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* shadowFilterName(ShadowFilter filter) {
+    switch (filter) {
+    case ShadowFilter::Hard: return "hard";
+    case ShadowFilter::Poisson4: return "poisson4";
+    case ShadowFilter::Pcf3x3: return "pcf3x3";
+    case ShadowFilter::Pcf5x5: return "pcf5x5";
+    }
+    return "unknown";
+}
+
+bool parseShadowFilter(const char* name, ShadowFilter& filter) {
+    const ShadowFilter all[] = {ShadowFilter::Hard, ShadowFilter::Poisson4, ShadowFilter::Pcf3x3, ShadowFilter::Pcf5x5};
+    for (ShadowFilter candidate : all) {
+        if (std::strcmp(name, shadowFilterName(candidate)) == 0) {
+            filter = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
 void Renderer::setViewportSize(int width, int height) {
     viewportWidth = std::max(1, width);
     viewportHeight = std::max(1, height);
 }
 
+void Renderer::setTargetFramebuffer(unsigned int fbo) {
+    targetFramebuffer = fbo;
+}
+
 void Renderer::clearChunksAndMeshes() {
-    for (auto& entry : chunkMeshes) {
-        if (entry.second.vao) glDeleteVertexArrays(1, &entry.second.vao);
-        if (entry.second.vbo) glDeleteBuffers(1, &entry.second.vbo);
-    }
+    cancelAllJobs();
+    heightfield.clear();
+    meshArena.releaseAll();
     chunkMeshes.clear();
     chunkData.clear();
+    chunkDataBytes = 0;
+    dataCache.clear();
+    meshCache.clear();
+    for (ShadowCascade& cascade : cascades) cascade.valid = false;
     visitedChunks.clear();
+    generateQueue.clear();
+    meshQueue.clear();
+    visibleSetValid = false;
+}
+
+void Renderer::clearMeshes() {
+    // In-flight mesh jobs see their cancel flag and their results are dropped in applyCompletedJobs
+    for (auto& entry : pendingMesh) entry.second->store(true);
+    pendingMesh.clear();
+    meshArena.releaseAll();
+    chunkMeshes.clear();
+    meshCache.clear();
+    for (ShadowCascade& cascade : cascades) cascade.valid = false;
+    for (const auto& chunk : visitedChunks) {
+        meshQueue.push_back(chunk);
+    }
 }
 
 void Renderer::reseedNoise() {
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_real_distribution<float> dist(-10000.0f, 10000.0f);
-    noiseOffsetX = dist(gen);
-    noiseOffsetZ = dist(gen);
+    noiseOffset.x = dist(gen);
+    noiseOffset.z = dist(gen);
     clearChunksAndMeshes();
 }
 
@@ -173,10 +318,12 @@ void Renderer::initialise() {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_real_distribution<float> dist(-10000.0f, 10000.0f);
-        noiseOffsetX = dist(gen);
-        noiseOffsetZ = dist(gen);
+        noiseOffset.x = dist(gen);
+        noiseOffset.z = dist(gen);
         noiseSeeded = true;
     }
+    dataCache.setBudget(dataCacheBudget);
+    meshCache.setBudget(meshCacheBudget);
 
     // Define vertices for a 3D cube (counter-clockwise order)
     float vertices[] = {
@@ -218,44 +365,88 @@ void Renderer::initialise() {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    // Load and compile shaders
-    shaderProgram = loadShaders("shaders/vertexShader.vert", "shaders/fragmentShader.frag");
-    depthShaderProgram = loadShaders("shaders/shadowDepth.vert", "shaders/shadowDepth.frag");
-    if (shaderProgram == 0) {
+    // Load and compile shaders, the main program with the chosen shadow filter variant
+    const char* filterDefine = "#define SHADOW_FILTER_PCF5X5\n";
+    switch (shadowFilter) {
+    case ShadowFilter::Hard: filterDefine = "#define SHADOW_FILTER_HARD\n"; break;
+    case ShadowFilter::Poisson4: filterDefine = "#define SHADOW_FILTER_POISSON4\n"; break;
+    case ShadowFilter::Pcf3x3: filterDefine = "#define SHADOW_FILTER_PCF3X3\n"; break;
+    case ShadowFilter::Pcf5x5: break;
+    }
+    if (!shaderProgram.load("shaders/vertexShader.vert", "shaders/fragmentShader.frag", filterDefine)) {
         std::cerr << "Failed to load shaders." << std::endl;
         return;
     }
-    if (depthShaderProgram == 0) {
+    if (!depthShaderProgram.load("shaders/shadowDepth.vert", "shaders/shadowDepth.frag")) {
         std::cerr << "Failed to load depth shaders." << std::endl;
         return;
     }
+    shaderProgram.use();
+    glUniform1i(shaderProgram.uniform("shadowMap"), 0);
+    depthCascadeUniform = depthShaderProgram.uniform("cascade");
+    for (const ShaderProgram* program : {&shaderProgram, &depthShaderProgram}) {
+        program->use();
+        glUniform1i(program->uniform("chunkOrigins"), CHUNK_ORIGINS_UNIT);
+        glUniform1i(program->uniform("granuleVertices"), static_cast<int>(VertexArena::GRANULE_VERTICES));
+    }
+    glUseProgram(0);
+
+    if (drawSubmission == DrawSubmission::Indirect && !(GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect)) {
+        std::cout << "Indirect multi-draw needs GL 4.3 or ARB_multi_draw_indirect; using glMultiDrawElementsBaseVertex." << std::endl;
+        drawSubmission = DrawSubmission::MultiDraw;
+    }
+    if (drawSubmission == DrawSubmission::Indirect) {
+        glGenBuffers(1, &indirectBuffer);
+    }
 
-    // Set up shadow map framebuffer
-    glGenFramebuffers(1, &depthMapFBO);
+    // Camera and light state for both programs, filled in by render()
+    glGenBuffers(1, &frameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameUniformBuffer);
+    if (!shaderProgram.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING) ||
+        !depthShaderProgram.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING)) {
+        std::cerr << "FrameUniforms block missing from a shader program." << std::endl;
+    }
+
+    // Set up the cascaded shadow map: one depth texture array, one framebuffer per layer
     glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, shadowMapSize, shadowMapSize, shadowCascadeCount, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
     float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        std::cerr << "Depth framebuffer not complete!" << std::endl;
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+    // Sampled through sampler2DArrayShadow: each fetch compares against the reference depth and filters the results
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    for (int i = 0; i < shadowCascadeCount; ++i) {
+        glGenFramebuffers(1, &cascades[i].fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, cascades[i].fbo);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, i);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Depth framebuffer of cascade " << i << " not complete!" << std::endl;
+        }
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    std::cout << "World settings -> CHUNK_SIZE: " << CHUNK_SIZE
-              << ", CHUNK_HEIGHT: " << CHUNK_HEIGHT
-              << ", VIEW_DISTANCE: " << VIEW_DISTANCE
-              << ", MAX_CHUNK_BUILDS_PER_FRAME: " << MAX_CHUNK_BUILDS_PER_FRAME
-              << ", noise offsets: (" << noiseOffsetX << ", " << noiseOffsetZ << ")"
+    std::cout << "World settings -> CHUNK_SIZE: " << chunkDims.size
+              << ", CHUNK_HEIGHT: " << chunkDims.height
+              << ", VIEW_DISTANCE: " << viewDistance
+              << ", MAX_CHUNK_UPLOADS_PER_FRAME: " << MAX_CHUNK_UPLOADS_PER_FRAME
+              << ", chunk workers: " << jobPool.threadCount()
+              << ", draw submission: " << drawSubmissionName(drawSubmission)
+              << ", shadow cascades: " << shadowCascadeCount << " x " << shadowMapSize
+              << " (" << shadowFilterName(shadowFilter) << ")"
+              << ", noise offsets: (" << noiseOffset.x << ", " << noiseOffset.z << ")"
               << std::endl;
 
     // Enable depth testing
@@ -279,7 +470,7 @@ void Renderer::initialise() {
     std::cout << "Face Culling Enabled: " << (cullFaceEnabled ? "Yes" : "No") << std::endl;
 
     // Verify shader program
-    if (shaderProgram == 0) {
+    if (!shaderProgram.valid()) {
         std::cerr << "Shader program failed to load." << std::endl;
     } else {
         std::cout << "Shader program loaded successfully." << std::endl;
@@ -301,6 +492,8 @@ void Renderer::initialise() {
 }
 
 void Renderer::render() {
+    frameStats = FrameStats{};
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Update viewport in case the window was resized
@@ -308,129 +501,128 @@ void Renderer::render() {
 
     // View/projection from camera
     glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 project = glm::perspective(glm::radians(45.0f), static_cast<float>(viewportWidth) / static_cast<float>(viewportHeight), 0.1f, 2000.0f);
+    const float aspect = static_cast<float>(viewportWidth) / static_cast<float>(viewportHeight);
+    glm::mat4 project = glm::perspective(glm::radians(CAMERA_FOV_DEGREES), aspect, CAMERA_NEAR, CAMERA_FAR);
 
     // Directional light setup
-    glm::vec3 lightDir = glm::normalize(glm::vec3(-0.5f, -1.2f, -0.3f));
-    float shadowRange = 80.0f;
-    glm::vec3 lightPos = camera.Position - lightDir * 50.0f;
-    glm::mat4 lightProj = glm::ortho(-shadowRange, shadowRange, -shadowRange, shadowRange, 1.0f, 200.0f);
-    glm::mat4 lightView = glm::lookAt(lightPos, camera.Position, glm::vec3(0.0f, 1.0f, 0.0f));
-    glm::mat4 lightSpace = lightProj * lightView;
-
-    // Build/generate a limited number of missing chunks per frame
-    int buildsThisFrame = 0;
-    for (const auto& chunk : visitedChunks) {
-        bool hasData = chunkData.find(chunk) != chunkData.end();
-        bool hasMesh = chunkMeshes.find(chunk) != chunkMeshes.end();
-        bool needsBuild = !hasData || !hasMesh;
-
-        if (needsBuild && buildsThisFrame >= MAX_CHUNK_BUILDS_PER_FRAME) {
-            continue; // defer generation/meshing to later frames
-        }
-
-        if (!hasData) {
-            generateChunk(chunk);
-        }
-        if (!hasMesh) {
-            buildChunkMesh(chunk);
-        }
-        if (needsBuild) {
-            buildsThisFrame++;
+    glm::vec3 lightDir = glm::normalize(glm::vec3(LIGHT_DIRECTION[0], LIGHT_DIRECTION[1], LIGHT_DIRECTION[2]));
+
+    // One upload per frame; both passes read it through the FrameUniforms block
+    FrameUniformBlock frameUniforms;
+    frameUniforms.view = view;
+    frameUniforms.projection = project;
+    frameUniforms.lightDir = glm::vec4(lightDir, 0.0f);
+    frameUniforms.lightColor = glm::vec4(1.0f, 0.95f, 0.9f, 1.0f);
+    frameUniforms.ambientColor = glm::vec4(0.2f, 0.2f, 0.22f, 1.0f);
+    frameUniforms.shadowTexelSize = glm::vec4(1.0f / shadowMapSize, 1.0f / shadowMapSize,
+                                              static_cast<float>(shadowCascadeCount), 0.0f);
+
+    // Cascades split the view out to the edge of the loaded chunks, part way between logarithmic and uniform
+    // splits, and each one covers the bounding sphere of its slice of the view frustum
+    const float shadowFar = std::min(CAMERA_FAR, static_cast<float>(viewDistance * chunkDims.size));
+    const float tanHalfFovY = std::tan(glm::radians(CAMERA_FOV_DEGREES) * 0.5f);
+    glm::mat4 cascadeLightSpace[MAX_SHADOW_CASCADES];
+    float splitNear = CAMERA_NEAR;
+    for (int i = 0; i < shadowCascadeCount; ++i) {
+        const float fraction = static_cast<float>(i + 1) / static_cast<float>(shadowCascadeCount);
+        const float uniformSplit = CAMERA_NEAR + (shadowFar - CAMERA_NEAR) * fraction;
+        const float logSplit = CAMERA_NEAR * std::pow(shadowFar / CAMERA_NEAR, fraction);
+        const float splitFar = uniformSplit + (logSplit - uniformSplit) * SHADOW_SPLIT_BLEND;
+        const CascadeSphere sphere = fitCascadeSphere(splitNear, splitFar, tanHalfFovY, aspect);
+        cascadeLightSpace[i] = snappedLightSpace(camera.Position + camera.Front * sphere.centreDepth, lightDir,
+                                                 sphere.radius, shadowMapSize);
+        frameUniforms.cascadeLightSpace[i] = cascadeLightSpace[i];
+        frameUniforms.cascadeSplits[i] = splitFar;
+        // Depth-buffer units spanned by one texel's width, which the main pass scales its bias by
+        const float texel = 2.0f * sphere.radius / shadowMapSize;
+        frameUniforms.cascadeTexelDepth[i] = texel / (2.0f * sphere.radius + SHADOW_CASTER_MARGIN);
+        splitNear = splitFar;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformBlock), &frameUniforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Upload meshes finished by the workers and queue generation/meshing for missing chunks
+    applyCompletedJobs();
+    scheduleChunkJobs();
+
+    // Depth passes, per cascade: the whole layer when its light volume moved, only the region where
+    // casters changed otherwise. Far cascades have larger texels, so they move less often than near ones.
+    for (int i = 0; i < shadowCascadeCount; ++i) {
+        ShadowCascade& cascade = cascades[i];
+        if (!shadowCaching || !cascade.valid || cascadeLightSpace[i] != cascade.lightSpace) {
+            renderDepthPass(i, cascadeLightSpace[i], nullptr);
+            cascade.lightSpace = cascadeLightSpace[i];
+            cascade.valid = true;
+            cascade.dirty = false;
+            frameStats.shadowUpdate = 2;
+            frameStats.shadowCascadesUpdated++;
+        } else if (cascade.dirty) {
+            renderDepthPass(i, cascadeLightSpace[i], &cascade.dirtyRegion);
+            cascade.dirty = false;
+            frameStats.shadowUpdate = std::max(frameStats.shadowUpdate, 1);
+            frameStats.shadowCascadesUpdated++;
         }
     }
 
-    // Depth pass
-    renderDepthPass(lightSpace);
-
     // Main pass
-    glUseProgram(shaderProgram);
-    GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLint projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLint lightSpaceLoc = glGetUniformLocation(shaderProgram, "lightSpaceMatrix");
-    GLint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-    GLint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLint ambientColorLoc = glGetUniformLocation(shaderProgram, "ambientColor");
-    GLint shadowMapLoc = glGetUniformLocation(shaderProgram, "shadowMap");
-    GLint shadowTexelSizeLoc = glGetUniformLocation(shaderProgram, "shadowTexelSize");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(project));
-    glUniformMatrix4fv(lightSpaceLoc, 1, GL_FALSE, glm::value_ptr(lightSpace));
-    glUniform3fv(lightDirLoc, 1, glm::value_ptr(lightDir));
-    glm::vec3 lightColor(1.0f, 0.95f, 0.9f);
-    glm::vec3 ambientColor(0.2f, 0.2f, 0.22f);
-    glUniform3fv(lightColorLoc, 1, glm::value_ptr(lightColor));
-    glUniform3fv(ambientColorLoc, 1, glm::value_ptr(ambientColor));
-    glUniform1i(shadowMapLoc, 0);
-    glUniform2f(shadowTexelSizeLoc, 1.0f / SHADOW_MAP_SIZE, 1.0f / SHADOW_MAP_SIZE);
-    glm::mat4 identityModel(1.0f);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(identityModel));
+    shaderProgram.use();
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
 
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
     glFrontFace(GL_CCW);
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-    for (const auto& chunk : visitedChunks) {
-        auto meshIt = chunkMeshes.find(chunk);
-        if (meshIt == chunkMeshes.end() || meshIt->second.vertexCount == 0) {
-            continue;
-        }
-        glBindVertexArray(meshIt->second.vao);
-        glDrawArrays(GL_TRIANGLES, 0, meshIt->second.vertexCount);
-    }
-
+    drawChunkMeshes(project * view, false, frameStats.chunksDrawn, frameStats.chunksCulled);
     glBindVertexArray(0);
+    // Meshes and data that left the view were already released (or cached) in updateVisitedChunks
 
-    // Clean up meshes and data no longer in view to keep memory/draw list small
-    std::vector<std::pair<int, int>> toRemove;
-    for (const auto& entry : chunkMeshes) {
-        if (visitedChunks.find(entry.first) == visitedChunks.end()) {
-            toRemove.push_back(entry.first);
-        }
-    }
-    for (const auto& key : toRemove) {
-        auto it = chunkMeshes.find(key);
-        if (it != chunkMeshes.end()) {
-            if (it->second.vao) glDeleteVertexArrays(1, &it->second.vao);
-            if (it->second.vbo) glDeleteBuffers(1, &it->second.vbo);
-            chunkMeshes.erase(it);
-        }
-        chunkData.erase(key);
-    }
 }
 
-void Renderer::renderDepthPass(const glm::mat4& lightSpace) {
-    // Depth-only pass from light POV
-    glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+void Renderer::renderDepthPass(int cascade, const glm::mat4& lightSpace, const ShadowRegion* region) {
+    // Depth-only pass from light POV into the cascade's layer
+    const int size = shadowMapSize;
+    glViewport(0, 0, size, size);
+    glBindFramebuffer(GL_FRAMEBUFFER, cascades[cascade].fbo);
+    // Culled against the cascade's ortho volume: chunks that can't cast into its layer are skipped.
+    // A partial update clears and redraws only the texels of the region, culling against its sub-volume.
+    glm::mat4 cullMatrix = lightSpace;
+    if (region) {
+        // One texel of margin, so texels the region's edges only partly cover are redrawn too
+        const int x0 = std::max(0, static_cast<int>(std::floor((region->min.x * 0.5f + 0.5f) * size)) - 1);
+        const int y0 = std::max(0, static_cast<int>(std::floor((region->min.y * 0.5f + 0.5f) * size)) - 1);
+        const int x1 = std::min(size, static_cast<int>(std::ceil((region->max.x * 0.5f + 0.5f) * size)) + 1);
+        const int y1 = std::min(size, static_cast<int>(std::ceil((region->max.y * 0.5f + 0.5f) * size)) + 1);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x0, y0, x1 - x0, y1 - y0);
+        // Maps the scissor rectangle (in NDC) onto [-1, 1] so the frustum test keeps only chunks overlapping it
+        const glm::vec2 ndcMin = glm::vec2(x0, y0) / static_cast<float>(size) * 2.0f - 1.0f;
+        const glm::vec2 ndcMax = glm::vec2(x1, y1) / static_cast<float>(size) * 2.0f - 1.0f;
+        glm::mat4 toRegion(1.0f);
+        toRegion[0][0] = 2.0f / (ndcMax.x - ndcMin.x);
+        toRegion[1][1] = 2.0f / (ndcMax.y - ndcMin.y);
+        toRegion[3][0] = -(ndcMax.x + ndcMin.x) / (ndcMax.x - ndcMin.x);
+        toRegion[3][1] = -(ndcMax.y + ndcMin.y) / (ndcMax.y - ndcMin.y);
+        cullMatrix = toRegion * lightSpace;
+    }
     glClear(GL_DEPTH_BUFFER_BIT);
     glCullFace(GL_BACK);
     glEnable(GL_POLYGON_OFFSET_FILL);
     glPolygonOffset(2.0f, 4.0f); // push depth slightly to reduce gaps
 
-    glUseProgram(depthShaderProgram);
-    GLint lightSpaceLoc = glGetUniformLocation(depthShaderProgram, "lightSpaceMatrix");
-    GLint modelLoc = glGetUniformLocation(depthShaderProgram, "model");
-    glm::mat4 identityModel(1.0f);
-    glUniformMatrix4fv(lightSpaceLoc, 1, GL_FALSE, glm::value_ptr(lightSpace));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(identityModel));
-
-    for (const auto& chunk : visitedChunks) {
-        auto meshIt = chunkMeshes.find(chunk);
-        if (meshIt == chunkMeshes.end() || meshIt->second.vertexCount == 0) {
-            continue;
-        }
-        glBindVertexArray(meshIt->second.vao);
-        glDrawArrays(GL_TRIANGLES, 0, meshIt->second.vertexCount);
-    }
+    depthShaderProgram.use();
+    glUniform1i(depthCascadeUniform, cascade);
 
+    // Faces turned away from the light would be culled as back faces, so only the light-facing prefix
+    // of each mesh is submitted
+    drawChunkMeshes(cullMatrix, true, frameStats.shadowChunksDrawn, frameStats.shadowChunksCulled);
     glBindVertexArray(0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
     glDisable(GL_POLYGON_OFFSET_FILL);
     glCullFace(GL_BACK);
 
@@ -438,99 +630,142 @@ void Renderer::renderDepthPass(const glm::mat4& lightSpace) {
     glViewport(0, 0, viewportWidth, viewportHeight);
 }
 
-void Renderer::generateChunk(const std::pair<int, int>& chunk) {
-    if (chunkData.find(chunk) != chunkData.end()) {
+void Renderer::drawChunkMeshes(const glm::mat4& viewProjection, bool shadowCasters, int& drawn, int& culled) {
+    const Frustum frustum = Frustum::fromMatrix(viewProjection);
+    const bool batched = drawSubmission != DrawSubmission::PerChunk;
+    drawBatches.resize(meshArena.pageCount());
+    for (DrawBatch& batch : drawBatches) {
+        batch.baseVertices.clear();
+        batch.counts.clear();
+    }
+    const GLenum indexType = meshArena.quadIndexType();
+    int boundPage = -1;
+    for (const auto& chunk : visitedChunks) {
+        auto meshIt = chunkMeshes.find(chunk);
+        if (meshIt == chunkMeshes.end()) {
+            continue;
+        }
+        const ChunkMesh& mesh = meshIt->second;
+        const int vertexCount = shadowCasters ? mesh.shadowVertexCount : mesh.vertexCount;
+        if (vertexCount == 0) {
+            continue;
+        }
+        if (frustumCulling && !frustum.intersectsBox(mesh.boundsMin, mesh.boundsMax)) {
+            culled++;
+            continue;
+        }
+        drawn++;
+        frameStats.verticesDrawn += vertexCount;
+        if (shadowCasters) {
+            frameStats.shadowVerticesDrawn += vertexCount;
+        }
+        const int indexCount = vertexCount / QUAD_VERTICES * QUAD_INDICES;
+        if (batched) {
+            DrawBatch& batch = drawBatches[mesh.allocation.page];
+            batch.baseVertices.push_back(static_cast<int>(mesh.allocation.first));
+            batch.counts.push_back(indexCount);
+            continue;
+        }
+        // Meshes share their arena page's VAO; only rebind when the page changes
+        if (mesh.allocation.page != boundPage) {
+            boundPage = mesh.allocation.page;
+            bindArenaPage(boundPage);
+        }
+        glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, indexType, nullptr, static_cast<GLint>(mesh.allocation.first));
+        frameStats.drawCalls++;
+    }
+    if (!batched) {
         return;
     }
 
-    std::vector<uint8_t> blocks(CHUNK_SIZE * CHUNK_HEIGHT * CHUNK_SIZE, static_cast<uint8_t>(BlockType::Air));
-    auto blockIndex = [](int lx, int ly, int lz) {
-        return (ly * CHUNK_SIZE + lz) * CHUNK_SIZE + lx;
-    };
-
-    int chunkMinX = chunk.first * CHUNK_SIZE;
-    int chunkMinZ = chunk.second * CHUNK_SIZE;
-
-    auto heightNoise = [&](float wx, float wz) {
-        float x = wx + noiseOffsetX;
-        float z = wz + noiseOffsetZ;
-        float continent = octavePerlin(x * terrainSettings.continentFreq, z * terrainSettings.continentFreq, 0.0f, 4, 0.5f);
-        float detail = octavePerlin(x * terrainSettings.detailFreq, z * terrainSettings.detailFreq, 0.0f, 3, 0.6f);
-        return continent * terrainSettings.continentWeight + detail * terrainSettings.detailWeight;
-    };
-
-    std::vector<int> heights(CHUNK_SIZE * CHUNK_SIZE, 0);
-
-    for (int lx = 0; lx < CHUNK_SIZE; ++lx) {
-        int worldX = chunkMinX + lx;
-        for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
-            int worldZ = chunkMinZ + lz;
-
-            float hCenter = heightNoise(worldX + 0.5f, worldZ + 0.5f);
-            float hN = heightNoise(worldX + 0.5f, worldZ - 0.8f);
-            float hS = heightNoise(worldX + 0.5f, worldZ + 1.8f);
-            float hE = heightNoise(worldX + 1.8f, worldZ + 0.5f);
-            float hW = heightNoise(worldX - 0.8f, worldZ + 0.5f);
-            float hNE = heightNoise(worldX + 1.8f, worldZ - 0.8f);
-            float hNW = heightNoise(worldX - 0.8f, worldZ - 0.8f);
-            float hSE = heightNoise(worldX + 1.8f, worldZ + 1.8f);
-            float hSW = heightNoise(worldX - 0.8f, worldZ + 1.8f);
-
-            float sum = hCenter * terrainSettings.smoothingCenterWeight
-                      + (hN + hS + hE + hW) * terrainSettings.smoothingEdgeWeight
-                      + (hNE + hNW + hSE + hSW) * terrainSettings.smoothingDiagWeight;
-            float weight = terrainSettings.smoothingCenterWeight
-                         + 4.0f * terrainSettings.smoothingEdgeWeight
-                         + 4.0f * terrainSettings.smoothingDiagWeight;
-            float blended = sum / weight;
-            float heightValue = pow(blended * 0.5f + 0.5f, terrainSettings.heightCurve);
-
-            int baseHeight = static_cast<int>(CHUNK_HEIGHT * terrainSettings.baseHeightFraction);
-            int heightRange = static_cast<int>(CHUNK_HEIGHT * terrainSettings.heightRangeFraction);
-            int columnHeight = std::clamp(baseHeight + static_cast<int>(std::round(heightValue * heightRange)), 2, CHUNK_HEIGHT - 2);
-
-            // Clamp slope against immediate neighbors to keep chunk borders aligned
-            if (lx > 0) {
-                int west = heights[lz * CHUNK_SIZE + (lx - 1)];
-                columnHeight = std::clamp(columnHeight, west - 2, west + 2);
+    // One multi-draw per arena page; chunk origins come from the page's buffer texture, so no state changes in between
+    const bool indirect = drawSubmission == DrawSubmission::Indirect;
+    if (indirect) {
+        indirectCommands.clear();
+        for (const DrawBatch& batch : drawBatches) {
+            for (size_t i = 0; i < batch.counts.size(); ++i) {
+                // DrawElementsIndirectCommand: count, instanceCount, firstIndex, baseVertex, baseInstance
+                indirectCommands.insert(indirectCommands.end(), {static_cast<uint32_t>(batch.counts[i]), 1u, 0u,
+                                                                 static_cast<uint32_t>(batch.baseVertices[i]), 0u});
             }
-            if (lz > 0) {
-                int north = heights[(lz - 1) * CHUNK_SIZE + lx];
-                columnHeight = std::clamp(columnHeight, north - 2, north + 2);
+        }
+        if (indirectCommands.empty()) {
+            return;
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCommands.size() * sizeof(uint32_t), indirectCommands.data(), GL_STREAM_DRAW);
+    }
+    constexpr size_t INDIRECT_COMMAND_WORDS = 5;
+    size_t commandOffset = 0;
+    for (int page = 0; page < meshArena.pageCount(); ++page) {
+        const DrawBatch& batch = drawBatches[page];
+        if (batch.counts.empty()) {
+            continue;
+        }
+        const GLsizei drawCount = static_cast<GLsizei>(batch.counts.size());
+        bindArenaPage(page);
+        if (indirect) {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, indexType,
+                                        (const void*)(commandOffset * INDIRECT_COMMAND_WORDS * sizeof(uint32_t)), drawCount, 0);
+        } else {
+            if (batchIndexOffsets.size() < batch.counts.size()) {
+                batchIndexOffsets.resize(batch.counts.size(), nullptr);
             }
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, batch.counts.data(), indexType, batchIndexOffsets.data(), drawCount,
+                                          batch.baseVertices.data());
+        }
+        commandOffset += batch.counts.size();
+        frameStats.drawCalls++;
+    }
+    if (indirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
 
-            heights[lz * CHUNK_SIZE + lx] = columnHeight;
+void Renderer::bindArenaPage(int page) {
+    glBindVertexArray(meshArena.pageVao(page));
+    glActiveTexture(GL_TEXTURE0 + CHUNK_ORIGINS_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, meshArena.pageOriginTexture(page));
+    glActiveTexture(GL_TEXTURE0);
+}
 
-            for (int y = 0; y < columnHeight; ++y) {
-                BlockType type = BlockType::Stone;
-                if (y >= columnHeight - 1) {
-                    type = BlockType::Grass;
-                } else if (y >= columnHeight - 4) {
-                    type = BlockType::Dirt;
-                }
-                blocks[blockIndex(lx, y, lz)] = static_cast<uint8_t>(type);
-            }
+void Renderer::generateChunk(const std::pair<int, int>& chunk) {
+    if (chunkData.find(chunk) != chunkData.end()) {
+        return;
+    }
 
-            if (columnHeight < WATER_LEVEL) {
-                for (int y = columnHeight; y <= WATER_LEVEL && y < CHUNK_HEIGHT; ++y) {
-                    blocks[blockIndex(lx, y, lz)] = static_cast<uint8_t>(BlockType::Water);
-                }
-            }
-        }
+    auto blocks = std::make_shared<ChunkVolume>(chunkStorage);
+    generateChunkBlocks(chunk, chunkDims, terrainSettings, noiseOffset, *blocks, &heightfield);
+    storeChunkData(chunk, std::move(blocks));
+    frameStats.chunksGenerated++;
+}
+
+bool Renderer::storeChunkData(const std::pair<int, int>& chunk, ChunkBlocks blocks) {
+    const size_t bytes = blocks->memoryBytes();
+    if (!chunkData.emplace(chunk, std::move(blocks)).second) {
+        return false;
     }
+    chunkDataBytes += bytes;
+    return true;
+}
 
-    chunkData.emplace(chunk, std::move(blocks));
+void Renderer::eraseChunkData(const std::pair<int, int>& chunk) {
+    auto it = chunkData.find(chunk);
+    if (it != chunkData.end()) {
+        chunkDataBytes -= it->second->memoryBytes();
+        chunkData.erase(it);
+    }
 }
 
 unsigned int Renderer::getBlockAt(int worldX, int worldY, int worldZ, bool generateMissing) {
-    if (worldY < 0 || worldY >= CHUNK_HEIGHT) {
+    if (worldY < 0 || worldY >= chunkDims.height) {
         return static_cast<unsigned int>(BlockType::Air);
     }
 
-    int chunkX = static_cast<int>(std::floor(static_cast<float>(worldX) / CHUNK_SIZE));
-    int chunkZ = static_cast<int>(std::floor(static_cast<float>(worldZ) / CHUNK_SIZE));
-    int localX = worldX - chunkX * CHUNK_SIZE;
-    int localZ = worldZ - chunkZ * CHUNK_SIZE;
+    int chunkX = floorDiv(worldX, chunkDims.size);
+    int chunkZ = floorDiv(worldZ, chunkDims.size);
+    int localX = worldX - chunkX * chunkDims.size;
+    int localZ = worldZ - chunkZ * chunkDims.size;
 
     std::pair<int, int> key(chunkX, chunkZ);
     if (generateMissing) {
@@ -541,261 +776,346 @@ unsigned int Renderer::getBlockAt(int worldX, int worldY, int worldZ, bool gener
         return static_cast<unsigned int>(BlockType::Air);
     }
 
-    int idx = (worldY * CHUNK_SIZE + localZ) * CHUNK_SIZE + localX;
-    if (idx < 0 || idx >= static_cast<int>(it->second.size())) {
-        return static_cast<unsigned int>(BlockType::Air);
-    }
+    return it->second->at(localX, worldY, localZ);
+}
 
-    return it->second[idx];
+bool Renderer::isChunkInRange(const std::pair<int, int>& chunk, int radius) const {
+    return std::abs(chunk.first - centerChunk.first) <= radius
+        && std::abs(chunk.second - centerChunk.second) <= radius;
 }
 
-void Renderer::buildChunkMesh(const std::pair<int, int>& chunk) {
-    // Skip if already built
-    if (chunkMeshes.find(chunk) != chunkMeshes.end()) {
-        return;
-    }
+void Renderer::pushJobResult(ChunkJobResult&& result) {
+    std::lock_guard<std::mutex> lock(completedMutex);
+    completedJobs.push_back(std::move(result));
+}
 
-    auto chunkIt = chunkData.find(chunk);
-    if (chunkIt == chunkData.end()) {
-        return;
+void Renderer::scheduleChunkJobs() {
+    // Only chunks queued by visible-set deltas or by newly arrived neighbour data are looked at;
+    // the same chunk can be queued more than once, so the queues are deduplicated first
+    std::sort(generateQueue.begin(), generateQueue.end());
+    generateQueue.erase(std::unique(generateQueue.begin(), generateQueue.end()), generateQueue.end());
+    std::vector<std::pair<int, int>> toGenerate;
+    for (const auto& chunk : generateQueue) {
+        if (!isChunkInRange(chunk, viewDistance + 1) || chunkData.find(chunk) != chunkData.end()
+            || pendingGenerate.find(chunk) != pendingGenerate.end()) {
+            continue;
+        }
+        ChunkBlocks cached;
+        if (dataCache.take(chunk, cached)) {
+            storeChunkData(chunk, std::move(cached));
+            queueMeshesAround(chunk);
+        } else {
+            toGenerate.push_back(chunk);
+        }
     }
-    const std::vector<uint8_t>& blocks = chunkIt->second;
+    generateQueue.clear();
 
-    auto blockIndex = [](int lx, int ly, int lz) {
-        return (ly * CHUNK_SIZE + lz) * CHUNK_SIZE + lx;
+    auto dataFor = [this](int cx, int cz) -> ChunkBlocks {
+        auto it = chunkData.find(std::make_pair(cx, cz));
+        return it == chunkData.end() ? nullptr : it->second;
     };
-
-    auto blockAt = [&](int worldX, int worldY, int worldZ) -> BlockType {
-        if (worldY < 0 || worldY >= CHUNK_HEIGHT) {
-            return BlockType::Air;
+    // Chunks still missing neighbour data are dropped here and queued again when that data arrives.
+    // Cached meshes go through completedJobs like a finished job, so they share the upload cap.
+    std::sort(meshQueue.begin(), meshQueue.end());
+    meshQueue.erase(std::unique(meshQueue.begin(), meshQueue.end()), meshQueue.end());
+    std::vector<std::pair<int, int>> toMesh;
+    for (const auto& chunk : meshQueue) {
+        if (visitedChunks.find(chunk) == visitedChunks.end()
+            || chunkMeshes.find(chunk) != chunkMeshes.end() || pendingMesh.find(chunk) != pendingMesh.end()) {
+            continue;
         }
-        // Allow pulling neighbor chunk data so we don't emit faces between solid neighboring chunks
-        return static_cast<BlockType>(getBlockAt(worldX, worldY, worldZ, true));
-    };
-
-    auto blockColor = [](BlockType type) -> glm::vec4 {
-        switch (type) {
-            case BlockType::Grass: return glm::vec4(0.2f, 0.7f, 0.2f, 1.0f);
-            case BlockType::Dirt:  return glm::vec4(0.45f, 0.27f, 0.12f, 1.0f);
-            case BlockType::Stone: return glm::vec4(0.55f, 0.55f, 0.55f, 1.0f);
-            case BlockType::Water: return glm::vec4(0.1f, 0.3f, 0.8f, 0.65f);
-            case BlockType::Air:
-            default:               return glm::vec4(0.0f);
+        if (!dataFor(chunk.first, chunk.second) || !dataFor(chunk.first - 1, chunk.second) || !dataFor(chunk.first + 1, chunk.second)
+            || !dataFor(chunk.first, chunk.second - 1) || !dataFor(chunk.first, chunk.second + 1)) {
+            continue;
         }
-    };
-
-    struct Vertex {
-        float x, y, z;
-        float r, g, b, a;
-        float nx, ny, nz;
-    };
-
-    // Face vertex templates (6 faces, 6 vertices each) in local cube space centered at block position
-    static const float faceVertices[6][18] = {
-        { // +Z (front)
-            -0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,
-             0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,  -0.5f, -0.5f,  0.5f
-        },
-        { // -Z (back)
-            -0.5f, -0.5f, -0.5f,  -0.5f,  0.5f, -0.5f,   0.5f,  0.5f, -0.5f,
-             0.5f,  0.5f, -0.5f,   0.5f, -0.5f, -0.5f,  -0.5f, -0.5f, -0.5f
-        },
-        { // -X (left)
-            -0.5f, -0.5f, -0.5f,  -0.5f, -0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,
-            -0.5f,  0.5f,  0.5f,  -0.5f,  0.5f, -0.5f,  -0.5f, -0.5f, -0.5f
-        },
-        { // +X (right)
-             0.5f, -0.5f, -0.5f,   0.5f,  0.5f, -0.5f,   0.5f,  0.5f,  0.5f,
-             0.5f,  0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f, -0.5f, -0.5f
-        },
-        { // +Y (top)
-            -0.5f,  0.5f, -0.5f,  -0.5f,  0.5f,  0.5f,   0.5f,  0.5f,  0.5f,
-             0.5f,  0.5f,  0.5f,   0.5f,  0.5f, -0.5f,  -0.5f,  0.5f, -0.5f
-        },
-        { // -Y (bottom)
-            -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f, -0.5f,  0.5f,
-             0.5f, -0.5f,  0.5f,  -0.5f, -0.5f,  0.5f,  -0.5f, -0.5f, -0.5f
+        CachedMesh cached;
+        if (meshCache.take(chunk, cached)) {
+            ChunkJobResult result;
+            result.chunk = chunk;
+            result.epoch = jobEpoch;
+            result.cancelled = std::make_shared<std::atomic<bool>>(false);
+            result.isMesh = true;
+            result.vertices = std::move(cached.vertices);
+            result.shadowVertexCount = cached.shadowVertexCount;
+            result.minCornerY = cached.minCornerY;
+            result.maxCornerY = cached.maxCornerY;
+            pendingMesh.emplace(chunk, result.cancelled);
+            pushJobResult(std::move(result));
+        } else {
+            toMesh.push_back(chunk);
         }
-    };
-
-    const int chunkMinX = chunk.first * CHUNK_SIZE;
-    const int chunkMinZ = chunk.second * CHUNK_SIZE;
-
-    std::vector<Vertex> vertices;
-    vertices.reserve(20000); // heuristic to avoid reallocations
-
-    for (int lx = 0; lx < CHUNK_SIZE; ++lx) {
-        for (int ly = 0; ly < CHUNK_HEIGHT; ++ly) {
-            for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
-                BlockType block = static_cast<BlockType>(blocks[blockIndex(lx, ly, lz)]);
-                if (block == BlockType::Air) {
-                    continue;
-                }
-
-                const int worldX = chunkMinX + lx;
-                const int worldZ = chunkMinZ + lz;
+    }
+    meshQueue.clear();
 
-                bool drawFace[6] = {
-                    blockAt(worldX, ly, worldZ + 1) == BlockType::Air, // +Z
-                    blockAt(worldX, ly, worldZ - 1) == BlockType::Air, // -Z
-                    blockAt(worldX - 1, ly, worldZ) == BlockType::Air, // -X
-                    blockAt(worldX + 1, ly, worldZ) == BlockType::Air, // +X
-                    blockAt(worldX, ly + 1, worldZ) == BlockType::Air, // +Y
-                    blockAt(worldX, ly - 1, worldZ) == BlockType::Air  // -Y
-                };
+    // Nearest chunks first so the area around the camera fills in before the horizon
+    auto byDistance = [this](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        int da = (a.first - centerChunk.first) * (a.first - centerChunk.first) + (a.second - centerChunk.second) * (a.second - centerChunk.second);
+        int db = (b.first - centerChunk.first) * (b.first - centerChunk.first) + (b.second - centerChunk.second) * (b.second - centerChunk.second);
+        return da < db;
+    };
+    std::sort(toGenerate.begin(), toGenerate.end(), byDistance);
+    std::sort(toMesh.begin(), toMesh.end(), byDistance);
+
+    const unsigned int epoch = jobEpoch;
+    for (const auto& chunk : toGenerate) {
+        CancelFlag cancelled = std::make_shared<std::atomic<bool>>(false);
+        pendingGenerate.emplace(chunk, cancelled);
+        const TerrainSettings settings = terrainSettings;
+        const NoiseOffset offset = noiseOffset;
+        const ChunkDimensions dims = chunkDims;
+        const ChunkStorage storage = chunkStorage;
+        jobPool.submit([this, chunk, dims, settings, offset, storage, epoch, cancelled] {
+            if (cancelled->load()) {
+                return;
+            }
+            auto blocks = std::make_shared<ChunkVolume>(storage);
+            generateChunkBlocks(chunk, dims, settings, offset, *blocks, &heightfield);
+            ChunkJobResult result;
+            result.chunk = chunk;
+            result.epoch = epoch;
+            result.cancelled = cancelled;
+            result.blocks = std::move(blocks);
+            pushJobResult(std::move(result));
+        });
+    }
+    for (const auto& chunk : toMesh) {
+        CancelFlag cancelled = std::make_shared<std::atomic<bool>>(false);
+        pendingMesh.emplace(chunk, cancelled);
+        ChunkNeighbourhood neighbourhood;
+        neighbourhood.center = dataFor(chunk.first, chunk.second);
+        neighbourhood.west = dataFor(chunk.first - 1, chunk.second);
+        neighbourhood.east = dataFor(chunk.first + 1, chunk.second);
+        neighbourhood.north = dataFor(chunk.first, chunk.second - 1);
+        neighbourhood.south = dataFor(chunk.first, chunk.second + 1);
+        const MeshingMode mode = meshingMode;
+        const ChunkDimensions dims = chunkDims;
+        const uint8_t casterFaces = lightFacingFaces(LIGHT_DIRECTION[0], LIGHT_DIRECTION[1], LIGHT_DIRECTION[2]);
+        jobPool.submit([this, chunk, dims, neighbourhood, mode, casterFaces, epoch, cancelled] {
+            if (cancelled->load()) {
+                return;
+            }
+            ChunkJobResult result;
+            result.chunk = chunk;
+            result.epoch = epoch;
+            result.cancelled = cancelled;
+            result.isMesh = true;
+            buildChunkVertices(chunk, dims, neighbourhood, result.vertices, mode);
+            result.shadowVertexCount = static_cast<int>(groupFacesFirst(result.vertices, casterFaces));
+            // Vertical extent for the culling bounds; x/z always span the chunk footprint
+            if (!result.vertices.empty()) {
+                auto range = std::minmax_element(result.vertices.begin(), result.vertices.end(),
+                    [](const PackedChunkVertex& a, const PackedChunkVertex& b) { return a.y < b.y; });
+                result.minCornerY = range.first->y;
+                result.maxCornerY = range.second->y;
+            }
+            pushJobResult(std::move(result));
+        });
+    }
+}
 
-                if (!(drawFace[0] || drawFace[1] || drawFace[2] || drawFace[3] || drawFace[4] || drawFace[5])) {
-                    continue;
-                }
+void Renderer::applyCompletedJobs() {
+    std::vector<ChunkJobResult> results;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        results.swap(completedJobs);
+    }
 
-                glm::vec4 color = blockColor(block);
-
-                for (int face = 0; face < 6; ++face) {
-                    if (!drawFace[face]) continue;
-                    const float* fv = faceVertices[face];
-                    glm::vec3 normal = glm::vec3(0.0f);
-                    if (face == 0) normal = glm::vec3(0, 0, 1);
-                    else if (face == 1) normal = glm::vec3(0, 0, -1);
-                    else if (face == 2) normal = glm::vec3(-1, 0, 0);
-                    else if (face == 3) normal = glm::vec3(1, 0, 0);
-                    else if (face == 4) normal = glm::vec3(0, 1, 0);
-                    else if (face == 5) normal = glm::vec3(0, -1, 0);
-                    for (int v = 0; v < 6; ++v) {
-                        Vertex vert;
-                        vert.x = fv[v * 3 + 0] + worldX;
-                        vert.y = fv[v * 3 + 1] + ly;
-                        vert.z = fv[v * 3 + 2] + worldZ;
-                        vert.r = color.r;
-                        vert.g = color.g;
-                        vert.b = color.b;
-                        vert.a = color.a;
-                        vert.nx = normal.x;
-                        vert.ny = normal.y;
-                        vert.nz = normal.z;
-                        vertices.push_back(vert);
-                    }
-                }
+    // GL uploads stay on this thread and are capped per frame; the rest wait for the next frame
+    std::vector<ChunkJobResult> deferred;
+    int uploads = 0;
+    for (auto& result : results) {
+        if (result.epoch != jobEpoch || result.cancelled->load()) {
+            continue;
+        }
+        if (result.isMesh && uploads >= MAX_CHUNK_UPLOADS_PER_FRAME) {
+            deferred.push_back(std::move(result));
+            continue;
+        }
+        auto& pending = result.isMesh ? pendingMesh : pendingGenerate;
+        auto pendingIt = pending.find(result.chunk);
+        if (pendingIt != pending.end() && pendingIt->second == result.cancelled) {
+            pending.erase(pendingIt);
+        }
+        if (!result.isMesh) {
+            if (storeChunkData(result.chunk, std::move(result.blocks))) {
+                frameStats.chunksGenerated++;
+                queueMeshesAround(result.chunk);
             }
+        } else if (chunkMeshes.find(result.chunk) == chunkMeshes.end()) {
+            uploadChunkMesh(result);
+            uploads++;
         }
     }
 
+    if (!deferred.empty()) {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completedJobs.insert(completedJobs.end(), std::make_move_iterator(deferred.begin()), std::make_move_iterator(deferred.end()));
+    }
+}
+
+void Renderer::cancelAllJobs() {
+    jobEpoch++;
+    jobPool.clearPending();
+    for (auto& entry : pendingGenerate) entry.second->store(true);
+    for (auto& entry : pendingMesh) entry.second->store(true);
+    pendingGenerate.clear();
+    pendingMesh.clear();
+    std::lock_guard<std::mutex> lock(completedMutex);
+    completedJobs.clear();
+}
+
+void Renderer::queueMeshesAround(const std::pair<int, int>& chunk) {
+    // This chunk and its neighbours may now have everything they need to mesh
+    meshQueue.push_back(chunk);
+    meshQueue.emplace_back(chunk.first - 1, chunk.second);
+    meshQueue.emplace_back(chunk.first + 1, chunk.second);
+    meshQueue.emplace_back(chunk.first, chunk.second - 1);
+    meshQueue.emplace_back(chunk.first, chunk.second + 1);
+}
+
+void Renderer::uploadChunkMesh(ChunkJobResult& result) {
+    const std::vector<PackedChunkVertex>& vertices = result.vertices;
     ChunkMesh mesh;
     mesh.vertexCount = static_cast<int>(vertices.size());
-    if (mesh.vertexCount > 0) {
-        glGenVertexArrays(1, &mesh.vao);
-        glGenBuffers(1, &mesh.vbo);
-        glBindVertexArray(mesh.vao);
-        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    mesh.shadowVertexCount = result.shadowVertexCount;
+    const glm::vec3 origin = chunkOrigin(result.chunk, chunkDims.size);
+    mesh.boundsMin = origin + glm::vec3(0.0f, static_cast<float>(result.minCornerY), 0.0f);
+    mesh.boundsMax = origin + glm::vec3(static_cast<float>(chunkDims.size), static_cast<float>(result.maxCornerY), static_cast<float>(chunkDims.size));
+    mesh.allocation = meshArena.upload(vertices, chunkOrigin(result.chunk, chunkDims.size));
+
+    chunkMeshes.emplace(result.chunk, mesh);
+    frameStats.chunksMeshed++;
+    if (visitedChunks.find(result.chunk) != visitedChunks.end()) {
+        markShadowCasterChanged(result.chunk);
+    }
+}
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(7 * sizeof(float)));
-        glEnableVertexAttribArray(2);
+void Renderer::markShadowCasterChanged(const std::pair<int, int>& chunk) {
+    auto meshIt = chunkMeshes.find(chunk);
+    if (meshIt == chunkMeshes.end() || meshIt->second.shadowVertexCount == 0) {
+        return;
+    }
+    const ChunkMesh& mesh = meshIt->second;
+    for (int i = 0; i < shadowCascadeCount; ++i) {
+        ShadowCascade& cascade = cascades[i];
+        if (!cascade.valid) {
+            continue;
+        }
+        // The mesh bounds in the cached layer's light space; chunks outside its volume never reached it
+        glm::vec3 lo(1e30f), hi(-1e30f);
+        for (int corner = 0; corner < 8; ++corner) {
+            const glm::vec3 world((corner & 1) ? mesh.boundsMax.x : mesh.boundsMin.x,
+                                  (corner & 2) ? mesh.boundsMax.y : mesh.boundsMin.y,
+                                  (corner & 4) ? mesh.boundsMax.z : mesh.boundsMin.z);
+            const glm::vec3 ndc = glm::vec3(cascade.lightSpace * glm::vec4(world, 1.0f)); // ortho: w stays 1
+            lo = glm::min(lo, ndc);
+            hi = glm::max(hi, ndc);
+        }
+        if (hi.x < -1.0f || lo.x > 1.0f || hi.y < -1.0f || lo.y > 1.0f || hi.z < -1.0f || lo.z > 1.0f) {
+            continue;
+        }
+        const glm::vec2 regionMin = glm::max(glm::vec2(lo), glm::vec2(-1.0f));
+        const glm::vec2 regionMax = glm::min(glm::vec2(hi), glm::vec2(1.0f));
+        if (cascade.dirty) {
+            cascade.dirtyRegion.min = glm::min(cascade.dirtyRegion.min, regionMin);
+            cascade.dirtyRegion.max = glm::max(cascade.dirtyRegion.max, regionMax);
+        } else {
+            cascade.dirtyRegion.min = regionMin;
+            cascade.dirtyRegion.max = regionMax;
+            cascade.dirty = true;
+        }
+    }
+}
 
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+void Renderer::updateVisitedChunks(const std::pair<int, int>& chunk) {
+    if (visibleSetValid && chunk == centerChunk) {
+        return;
+    }
+    const std::pair<int, int> previous = centerChunk;
+    const bool hadPrevious = visibleSetValid;
+    centerChunk = chunk;
+    visibleSetValid = true;
+
+    // Leaving strips: chunks out of view stop drawing; their meshes and data (with the one-chunk apron)
+    // stay loaded for CACHE_KEEP_RINGS more rings and then go to the caches
+    if (hadPrevious) {
+        forEachRingDelta(previous, chunk, true, viewDistance, [this](const std::pair<int, int>& left) {
+            visitedChunks.erase(left);
+            cancelPendingJob(pendingMesh, left);
+            markShadowCasterChanged(left);
+        });
+        forEachRingDelta(previous, chunk, true, viewDistance + CACHE_KEEP_RINGS, [this](const std::pair<int, int>& left) {
+            auto meshIt = chunkMeshes.find(left);
+            if (meshIt != chunkMeshes.end()) {
+                ChunkMesh& mesh = meshIt->second;
+                if (meshCache.getBudget() > 0) {
+                    // Bounds are the origin plus whole corner heights, so the extent converts back exactly
+                    const float originY = chunkOrigin(left, chunkDims.size).y;
+                    CachedMesh cached;
+                    meshArena.download(mesh.allocation, static_cast<uint32_t>(mesh.vertexCount), cached.vertices);
+                    cached.shadowVertexCount = mesh.shadowVertexCount;
+                    cached.minCornerY = static_cast<int>(std::lround(mesh.boundsMin.y - originY));
+                    cached.maxCornerY = static_cast<int>(std::lround(mesh.boundsMax.y - originY));
+                    const size_t bytes = sizeof(CachedMesh) + cached.vertices.capacity() * sizeof(PackedChunkVertex);
+                    meshCache.put(left, std::move(cached), bytes);
+                }
+                meshArena.release(mesh.allocation);
+                chunkMeshes.erase(meshIt);
+            }
+        });
+        forEachRingDelta(previous, chunk, true, viewDistance + 1 + CACHE_KEEP_RINGS, [this](const std::pair<int, int>& left) {
+            cancelPendingJob(pendingGenerate, left);
+            auto dataIt = chunkData.find(left);
+            if (dataIt != chunkData.end()) {
+                dataCache.put(left, dataIt->second, dataIt->second->memoryBytes());
+                eraseChunkData(left);
+            }
+        });
     }
 
-    chunkMeshes.emplace(chunk, mesh);
+    // Entering strips: data (with apron) to generate, visible chunks to mesh once their data is in
+    forEachRingDelta(chunk, previous, hadPrevious, viewDistance + 1, [this](const std::pair<int, int>& entered) {
+        generateQueue.push_back(entered);
+    });
+    forEachRingDelta(chunk, previous, hadPrevious, viewDistance, [this](const std::pair<int, int>& entered) {
+        visitedChunks.insert(entered);
+        meshQueue.push_back(entered);
+        markShadowCasterChanged(entered); // its mesh may still be loaded from the kept rings
+    });
 }
 
-void Renderer::updateVisitedChunks(const std::pair<int, int>& chunk) {
-    visitedChunks.clear();
-    for (int dx = -VIEW_DISTANCE; dx <= VIEW_DISTANCE; ++dx) {
-        for (int dz = -VIEW_DISTANCE; dz <= VIEW_DISTANCE; ++dz) {
-            visitedChunks.insert(std::make_pair(chunk.first + dx, chunk.second + dz));
-        }
+void Renderer::cancelPendingJob(std::map<std::pair<int, int>, CancelFlag>& pending, const std::pair<int, int>& chunk) {
+    auto it = pending.find(chunk);
+    if (it != pending.end()) {
+        it->second->store(true);
+        pending.erase(it);
     }
 }
 
 std::pair<int, int> Renderer::getCurrentChunk(float cameraX, float cameraZ) {
-    int chunkX = static_cast<int>(std::floor(cameraX / CHUNK_SIZE));
-    int chunkZ = static_cast<int>(std::floor(cameraZ / CHUNK_SIZE));
+    int chunkX = static_cast<int>(std::floor(cameraX / chunkDims.size));
+    int chunkZ = static_cast<int>(std::floor(cameraZ / chunkDims.size));
     return std::make_pair(chunkX, chunkZ);
 }
 
 void Renderer::cleanup() {
     // Good practice to clean up :)
-    glDeleteProgram(shaderProgram);
-    glDeleteProgram(depthShaderProgram);
+    cancelAllJobs();
+    shaderProgram.destroy();
+    depthShaderProgram.destroy();
+    if (frameUniformBuffer) glDeleteBuffers(1, &frameUniformBuffer);
+    frameUniformBuffer = 0;
+    if (indirectBuffer) glDeleteBuffers(1, &indirectBuffer);
+    indirectBuffer = 0;
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteBuffers(1, &cubeVBO);
     if (depthMap) glDeleteTextures(1, &depthMap);
-    if (depthMapFBO) glDeleteFramebuffers(1, &depthMapFBO);
-    for (auto& entry : chunkMeshes) {
-        if (entry.second.vao) glDeleteVertexArrays(1, &entry.second.vao);
-        if (entry.second.vbo) glDeleteBuffers(1, &entry.second.vbo);
+    for (ShadowCascade& cascade : cascades) {
+        if (cascade.fbo) glDeleteFramebuffers(1, &cascade.fbo);
+        cascade = ShadowCascade{};
     }
     chunkMeshes.clear();
-}
-
-unsigned int Renderer::loadShaders(const char* vertexPath, const char* fragmentPath) {
-    // Helper function so we can load shaders more neatly
-    std::string vertexCode, fragmentCode;
-    std::ifstream vShaderFile, fShaderFile;
-
-    vShaderFile.open(vertexPath);
-    fShaderFile.open(fragmentPath);
-
-    std::stringstream vShaderStream, fShaderStream;
-    vShaderStream << vShaderFile.rdbuf();
-    fShaderStream << fShaderFile.rdbuf();
-
-    vertexCode = vShaderStream.str();
-    fragmentCode = fShaderStream.str();
-
-    vShaderFile.close();
-    fShaderFile.close();
-
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
-
-    // Vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-        return 0;
-    }
-
-    // Fragment shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-        return 0;
-    }
-
-    // Shader program
-    unsigned int program = glCreateProgram();
-    glAttachShader(program, vertex);
-    glAttachShader(program, fragment);
-    glLinkProgram(program);
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        return 0;
-    }
-
-    // Cleaning up the shaders since they're already linked
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-
-    return program;
+    meshArena.destroy();
 }
 
 std::vector<float> Renderer::loadHeightMap(const std::string& filePath, int& width, int& height) {
@@ -1,37 +1,80 @@
 #pragma once
-#include <set>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <map>
 #include <glm/glm.hpp>
+#include "chunk.h"
+#include "chunk_cache.h"
+#include "chunk_map.h"
+#include "heightfield.h"
+#include "job_pool.h"
+#include "shader_program.h"
+#include "vertex_arena.h"
 
 struct ChunkMesh {
-    unsigned int vao = 0;
-    unsigned int vbo = 0;
+    // Range of the shared vertex arena holding this chunk's vertices
+    VertexArena::Allocation allocation;
     int vertexCount = 0;
+    // The mesh's light-facing faces come first (groupFacesFirst); the depth pass draws only these
+    int shadowVertexCount = 0;
+    // World-space bounds of the mesh, tested against the camera and light frusta
+    glm::vec3 boundsMin{0.0f};
+    glm::vec3 boundsMax{0.0f};
 };
 
-struct TerrainSettings {
-    // Noise frequency for the large-scale landmasses (lower -> wider features)
-    float continentFreq = 0.0135f;
-    // Noise frequency for finer surface detail (higher -> more local variation)
-    float detailFreq = 0.0060f;
-    // Blend weights between the low-frequency and high-frequency noise
-    float continentWeight = 0.85f;
-    float detailWeight = 0.15f;
-    // Smoothing kernel weights (center, edges, diagonals) to reduce jagged steps
-    float smoothingCenterWeight = 4.0f;
-    float smoothingEdgeWeight = 2.0f;
-    float smoothingDiagWeight = 1.0f;
-    // Exponent applied to the normalized height to shape slopes/plateaus (<1 flattens)
-    float heightCurve = 0.98f;
-    // Fractions of CHUNK_HEIGHT used for base and variable height range
-    float baseHeightFraction = 0.34f;
-    float heightRangeFraction = 0.32f;
+// Per-frame counters reset at the start of every render()
+struct FrameStats {
+    int chunksGenerated = 0;
+    int chunksMeshed = 0;
+    int drawCalls = 0;
+    // Vertices submitted by the depth and main passes together, and the depth passes' share of them
+    long long verticesDrawn = 0;
+    long long shadowVerticesDrawn = 0;
+    // Chunks with a mesh that passed/failed the camera frustum test (main pass) and the light volume test (depth pass)
+    int chunksDrawn = 0;
+    int chunksCulled = 0;
+    int shadowChunksDrawn = 0;
+    int shadowChunksCulled = 0;
+    // Most shadow map work any cascade needed this frame: 0 = reused as is, 1 = region re-rendered,
+    // 2 = fully re-rendered; and how many cascades had any of their layer re-rendered
+    int shadowUpdate = 0;
+    int shadowCascadesUpdated = 0;
 };
 
+// How the visible chunks of a pass are submitted. PerChunk is one glDrawElementsBaseVertex per chunk; MultiDraw
+// gathers them into one glMultiDrawElementsBaseVertex per arena page (GL 3.3); Indirect does the same from a
+// command buffer with glMultiDrawElementsIndirect (GL 4.3 or ARB_multi_draw_indirect)
+enum class DrawSubmission {
+    PerChunk,
+    MultiDraw,
+    Indirect
+};
+
+const char* drawSubmissionName(DrawSubmission submission);
+// Parses "per-chunk"/"multi-draw"/"indirect"; returns false for anything else
+bool parseDrawSubmission(const char* name, DrawSubmission& submission);
+
+// Shadow map filter compiled into fragmentShader.frag. Every tap is a hardware depth compare with bilinear
+// filtering, so even Hard gives a 2x2 PCF; Poisson4 takes 4 taps on a Poisson disc, Pcf3x3 and Pcf5x5 a grid
+enum class ShadowFilter {
+    Hard,
+    Poisson4,
+    Pcf3x3,
+    Pcf5x5
+};
+
+const char* shadowFilterName(ShadowFilter filter);
+// Parses "hard"/"poisson4"/"pcf3x3"/"pcf5x5"; returns false for anything else
+bool parseShadowFilter(const char* name, ShadowFilter& filter);
+
 class Renderer {
 public:
+    // Layers of the cascaded shadow map's depth texture array
+    static constexpr int MAX_SHADOW_CASCADES = 4;
+
     void initialise();
     void render();
     void cleanup();
@@ -40,28 +83,182 @@ public:
     void setViewportSize(int width, int height);
     void updateVisitedChunks(const std::pair<int, int>& chunk);
     std::pair<int, int> getCurrentChunk(float cameraX, float cameraZ);
-    unsigned int loadShaders(const char* vertexPath, const char* fragmentPath);
     static void setTerrainSettings(const TerrainSettings& settings);
     static TerrainSettings getTerrainSettings();
+    // Chunk footprint/height and view radius in chunks; call before initialise() (defaults 4x32, 32 chunks)
+    static void setWorldDimensions(const ChunkDimensions& dims, int viewDistance);
+    static ChunkDimensions getChunkDimensions();
+    static int getViewDistance();
+    // Use a fixed terrain seed instead of the random per-launch one
+    static void setNoiseOffset(const NoiseOffset& offset);
+    static void setMeshingMode(MeshingMode mode);
+    static MeshingMode getMeshingMode();
+    // Storage for newly generated chunks; switch before initialise() or follow with clearChunksAndMeshes()
+    static void setChunkStorage(ChunkStorage storage);
+    static ChunkStorage getChunkStorage();
+    // Byte budgets of the LRU caches holding chunk data and CPU-side meshes of chunks that left the view;
+    // call before initialise() (defaults 64 MiB each, 0 disables a cache)
+    static void setCacheBudgets(size_t dataBytes, size_t meshBytes);
+    // Frustum culling is on by default; turning it off draws every visited chunk (for comparison runs)
+    static void setFrustumCulling(bool enabled);
+    // Reusing the shadow map while the snapped light volume and its casters are unchanged is on by default;
+    // turning it off re-renders it every frame
+    static void setShadowCaching(bool enabled);
+    // Cascades (1 to MAX_SHADOW_CASCADES) splitting the shadowed part of the view, and the width/height of
+    // each cascade's layer; call before initialise() (defaults 3 x 2048, three quarters of one 4096 map's texels)
+    static void setShadowCascades(int count, int mapSize);
+    static int getShadowCascadeCount();
+    static int getShadowMapSize();
+    // Picks the shader variant at initialise() (default Pcf5x5)
+    static void setShadowFilter(ShadowFilter filter);
+    static ShadowFilter getShadowFilter();
+    // Defaults to Indirect; falls back to MultiDraw at initialise() when the context can't do indirect draws
+    static void setDrawSubmission(DrawSubmission submission);
+    static DrawSubmission getDrawSubmission();
     void clearChunksAndMeshes();
+    // Drops the chunk meshes (keeping block data) so they are rebuilt, e.g. after a meshing mode change
+    void clearMeshes();
     void reseedNoise();
+    // Framebuffer the main pass draws into (0 = window, headless runs use an offscreen FBO)
+    void setTargetFramebuffer(unsigned int fbo);
+    const FrameStats& getFrameStats() const { return frameStats; }
+    VertexArena::Stats getMeshArenaStats() const { return meshArena.getStats(); }
+    size_t getChunkDataCount() const { return chunkData.size(); }
+    // Bytes of block storage (ChunkVolume::memoryBytes) held for every loaded chunk
+    size_t getChunkDataBytes() const { return chunkDataBytes; }
+    ChunkCacheStats getDataCacheStats() const { return dataCache.getStats(); }
+    size_t getDataCacheBudget() const { return dataCache.getBudget(); }
+    // Holds every mesh built or reused, including the ones still uploaded
+    ChunkCacheStats getMeshCacheStats() const { return meshCache.getStats(); }
+    size_t getMeshCacheBudget() const { return meshCache.getBudget(); }
 
 private:
+    // Set when the chunk leaves the wanted area before its job has run
+    using CancelFlag = std::shared_ptr<std::atomic<bool>>;
+
+    // Output of a worker job, handed back to the render thread
+    struct ChunkJobResult {
+        std::pair<int, int> chunk;
+        unsigned int epoch = 0;
+        CancelFlag cancelled;
+        bool isMesh = false;
+        ChunkBlocks blocks;                // generation jobs
+        std::vector<PackedChunkVertex> vertices; // meshing jobs, light-facing faces first
+        int shadowVertexCount = 0;
+        int minCornerY = 0;                      // lowest/highest vertex y, in packed units
+        int maxCornerY = 0;
+    };
+
+    // A released mesh's vertices and vertical extent, so the chunk can come back without meshing
+    struct CachedMesh {
+        std::vector<PackedChunkVertex> vertices;
+        int shadowVertexCount = 0;
+        int minCornerY = 0;
+        int maxCornerY = 0;
+    };
+
     void generateChunk(const std::pair<int, int>& chunk);
-    void buildChunkMesh(const std::pair<int, int>& chunk);
+    // chunkData insert/erase that keep chunkDataBytes in step; store returns false if the chunk was already there
+    bool storeChunkData(const std::pair<int, int>& chunk, ChunkBlocks blocks);
+    void eraseChunkData(const std::pair<int, int>& chunk);
+    // Queues the chunk and its four neighbours for meshing after its data arrived
+    void queueMeshesAround(const std::pair<int, int>& chunk);
     unsigned int getBlockAt(int worldX, int worldY, int worldZ, bool generateMissing = true);
-    void renderDepthPass(const glm::mat4& lightSpace);
+    // Shadow-map area in light-space NDC (x/y in [-1, 1])
+    struct ShadowRegion {
+        glm::vec2 min{0.0f};
+        glm::vec2 max{0.0f};
+    };
+
+    // One layer of the cascaded shadow map, rendered and cached on its own
+    struct ShadowCascade {
+        unsigned int fbo = 0;
+        // Light space the layer was last fully rendered with, and the area whose casters changed since
+        glm::mat4 lightSpace{1.0f};
+        bool valid = false;
+        bool dirty = false;
+        ShadowRegion dirtyRegion;
+    };
+
+    // Renders a cascade's whole layer, or with `region` only the texels inside it
+    void renderDepthPass(int cascade, const glm::mat4& lightSpace, const ShadowRegion* region);
+    // A visible chunk's mesh appeared or went: marks the part of each cached cascade it covers for redraw
+    void markShadowCasterChanged(const std::pair<int, int>& chunk);
+    bool isChunkInRange(const std::pair<int, int>& chunk, int radius) const;
+    void scheduleChunkJobs();
+    void applyCompletedJobs();
+    void cancelAllJobs();
+    void cancelPendingJob(std::map<std::pair<int, int>, CancelFlag>& pending, const std::pair<int, int>& chunk);
+    void pushJobResult(ChunkJobResult&& result);
+    // Uploads the mesh into meshArena
+    void uploadChunkMesh(ChunkJobResult& result);
+    // Draws the visited meshes inside the frustum of `viewProjection`; `shadowCasters` draws only their light-facing faces
+    void drawChunkMeshes(const glm::mat4& viewProjection, bool shadowCasters, int& drawn, int& culled);
+    void bindArenaPage(int page);
 
     unsigned int cubeVBO = 0;
     unsigned int cubeVAO = 0;
-    unsigned int shaderProgram = 0;
-    unsigned int depthShaderProgram = 0;
-    unsigned int depthMapFBO = 0;
+    ShaderProgram shaderProgram;
+    ShaderProgram depthShaderProgram;
+    // std140 FrameUniforms block shared by both programs, rewritten once per frame
+    unsigned int frameUniformBuffer = 0;
+    // GL_TEXTURE_2D_ARRAY with one depth layer per cascade
     unsigned int depthMap = 0;
+    ShadowCascade cascades[MAX_SHADOW_CASCADES];
+    // Location of shadowDepth.vert's cascade index
+    int depthCascadeUniform = -1;
     int viewportWidth = 800;
     int viewportHeight = 600;
-    std::set<std::pair<int, int>> visitedChunks;
-    std::map<std::pair<int, int>, std::vector<uint8_t>> chunkData;
-    std::map<std::pair<int, int>, ChunkMesh> chunkMeshes;
+    unsigned int targetFramebuffer = 0;
+    FrameStats frameStats;
+    std::pair<int, int> centerChunk{0, 0};
+    ChunkSet visitedChunks;
+    ChunkMap<ChunkBlocks> chunkData;
+    size_t chunkDataBytes = 0;
+    ChunkMap<ChunkMesh> chunkMeshes;
+    // Data and meshes past the kept rings around the view; a mesh's vertices are read back from the arena
+    // when its GPU copy is released, so the budget only holds meshes that are not on the GPU
+    ChunkCache<ChunkBlocks> dataCache;
+    ChunkCache<CachedMesh> meshCache;
+    VertexArena meshArena;
+    // Per-page draw lists, rebuilt by every pass (kept to reuse their capacity)
+    struct DrawBatch {
+        std::vector<int> baseVertices; // first vertex of each mesh in the page
+        std::vector<int> counts;       // index counts
+    };
+    std::vector<DrawBatch> drawBatches;
+    // glMultiDrawElementsBaseVertex index offsets: every mesh starts at the first shared quad index
+    std::vector<const void*> batchIndexOffsets;
+    // DrawElementsIndirectCommand records for the Indirect path
+    std::vector<uint32_t> indirectCommands;
+    unsigned int indirectBuffer = 0;
+    std::map<std::pair<int, int>, CancelFlag> pendingGenerate;
+    std::map<std::pair<int, int>, CancelFlag> pendingMesh;
+    // Chunks whose data or mesh may now be needed, filled by visible-set deltas and arriving data
+    // and drained by scheduleChunkJobs
+    std::vector<std::pair<int, int>> generateQueue;
+    std::vector<std::pair<int, int>> meshQueue;
+    // False until the first updateVisitedChunks and after a terrain reset; the next update adds the full square
+    bool visibleSetValid = false;
+    std::mutex completedMutex;
+    std::vector<ChunkJobResult> completedJobs;
+    // Raw height noise shared between neighbouring chunks (used from worker threads)
+    HeightfieldCache heightfield;
+    // Bumped whenever terrain is reset so results from older jobs are ignored
+    unsigned int jobEpoch = 0;
     static TerrainSettings terrainSettings;
+    static MeshingMode meshingMode;
+    static ChunkStorage chunkStorage;
+    static size_t dataCacheBudget;
+    static size_t meshCacheBudget;
+    static ChunkDimensions chunkDims;
+    static int viewDistance;
+    static bool frustumCulling;
+    static bool shadowCaching;
+    static int shadowCascadeCount;
+    static int shadowMapSize;
+    static ShadowFilter shadowFilter;
+    static DrawSubmission drawSubmission;
+    // Declared last: the workers are joined before the state they report into is destroyed
+    JobPool jobPool;
 };
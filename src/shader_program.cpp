@@ -0,0 +1,126 @@
+#include "shader_program.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+std::string readFile(const char* path) {
+    std::ifstream file(path);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+// Puts `defines` after the #version line (which has to come first), then resets the line numbering so
+// compiler messages still point at the right lines of the file
+std::string insertDefines(const std::string& code, const std::string& defines) {
+    if (defines.empty()) {
+        return code;
+    }
+    const size_t versionEnd = code.compare(0, 8, "#version") == 0 ? code.find('\n') : std::string::npos;
+    if (versionEnd == std::string::npos) {
+        return defines + "#line 1\n" + code;
+    }
+    return code.substr(0, versionEnd + 1) + defines + "#line 2\n" + code.substr(versionEnd + 1);
+}
+
+unsigned int compileStage(GLenum type, const char* path, const char* label, const std::string& defines) {
+    std::string code = insertDefines(readFile(path), defines);
+    const char* source = code.c_str();
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::" << label << "::COMPILATION_FAILED (" << path << ")\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+} // namespace
+
+bool ShaderProgram::load(const char* vertexPath, const char* fragmentPath, const std::string& defines) {
+    destroy();
+    unsigned int vertex = compileStage(GL_VERTEX_SHADER, vertexPath, "VERTEX", defines);
+    unsigned int fragment = compileStage(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT", defines);
+    if (vertex == 0 || fragment == 0) {
+        if (vertex) glDeleteShader(vertex);
+        if (fragment) glDeleteShader(fragment);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    // Cleaning up the shaders since they're already linked
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        destroy();
+        return false;
+    }
+
+    // Resolve every active uniform now so the frame loop never asks the driver
+    int count = 0;
+    int maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(std::max(maxLength, 1));
+    for (int i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        std::string uniformName(name.data(), length);
+        // Arrays are reported as "name[0]"; store them under the bare name as well
+        int location = glGetUniformLocation(program, uniformName.c_str());
+        if (location < 0) {
+            continue; // uniform block member, set through the buffer instead
+        }
+        uniforms[uniformName] = location;
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) {
+            uniforms[uniformName.substr(0, uniformName.size() - 3)] = location;
+        }
+    }
+    return true;
+}
+
+void ShaderProgram::destroy() {
+    if (program) {
+        glDeleteProgram(program);
+    }
+    program = 0;
+    uniforms.clear();
+}
+
+void ShaderProgram::use() const {
+    glUseProgram(program);
+}
+
+int ShaderProgram::uniform(const std::string& name) const {
+    auto it = uniforms.find(name);
+    return it == uniforms.end() ? -1 : it->second;
+}
+
+bool ShaderProgram::bindUniformBlock(const char* blockName, unsigned int bindingPoint) const {
+    GLuint index = glGetUniformBlockIndex(program, blockName);
+    if (index == GL_INVALID_INDEX) {
+        return false;
+    }
+    glUniformBlockBinding(program, index, bindingPoint);
+    return true;
+}
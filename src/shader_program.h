@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+// Linked GLSL program with its uniform locations resolved once, right after linking.
+// Look locations up at init time and keep the ints; uniform() itself is a hash lookup, not a GL call.
+class ShaderProgram {
+public:
+    // Compiles and links the two stages; false (with the log on stderr) on failure. `defines` (e.g.
+    // "#define NAME\n" lines) is inserted into both stages right after their #version line.
+    bool load(const char* vertexPath, const char* fragmentPath, const std::string& defines = std::string());
+    void destroy();
+    void use() const;
+
+    // Location of an active uniform, -1 if the program has none by that name (e.g. optimised out)
+    int uniform(const std::string& name) const;
+    // Points a named uniform block at a binding point shared with glBindBufferBase; false if absent
+    bool bindUniformBlock(const char* blockName, unsigned int bindingPoint) const;
+
+    unsigned int id() const { return program; }
+    bool valid() const { return program != 0; }
+
+private:
+    unsigned int program = 0;
+    std::unordered_map<std::string, int> uniforms;
+};
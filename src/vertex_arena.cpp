@@ -0,0 +1,170 @@
+#include "vertex_arena.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+// Quad q's two triangles, 0-1-2 and 2-3-0 of its vertices
+template <typename Index>
+std::vector<Index> quadIndices(uint32_t quads) {
+    static const uint32_t pattern[QUAD_INDICES] = {0, 1, 2, 2, 3, 0};
+    std::vector<Index> indices(static_cast<size_t>(quads) * QUAD_INDICES);
+    for (uint32_t q = 0; q < quads; ++q) {
+        for (int i = 0; i < QUAD_INDICES; ++i) {
+            indices[static_cast<size_t>(q) * QUAD_INDICES + i] = static_cast<Index>(q * QUAD_VERTICES + pattern[i]);
+        }
+    }
+    return indices;
+}
+
+// Largest quad count 16-bit indices can address
+constexpr uint32_t MAX_SHORT_INDEX_QUADS = 65536 / QUAD_VERTICES;
+} // namespace
+
+VertexArena::Allocation VertexArena::upload(const std::vector<PackedChunkVertex>& vertices, const glm::vec3& origin) {
+    Allocation allocation;
+    if (vertices.empty()) {
+        return allocation;
+    }
+    const uint32_t count = static_cast<uint32_t>(vertices.size());
+    const uint32_t quads = count / QUAD_VERTICES;
+    if (quads > indexQuads) {
+        growQuadIndices(quads);
+    }
+    const uint32_t capacity = (count + GRANULE_VERTICES - 1) / GRANULE_VERTICES * GRANULE_VERTICES;
+
+    int page = -1;
+    uint32_t first = RangeAllocator::INVALID_OFFSET;
+    for (size_t i = 0; i < pages.size() && first == RangeAllocator::INVALID_OFFSET; ++i) {
+        first = pages[i].ranges.allocate(capacity);
+        page = static_cast<int>(i);
+    }
+    if (first == RangeAllocator::INVALID_OFFSET) {
+        page = addPage(std::max(PAGE_VERTICES, capacity));
+        first = pages[page].ranges.allocate(capacity);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, pages[page].vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(first) * sizeof(PackedChunkVertex),
+                    vertices.size() * sizeof(PackedChunkVertex), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    originScratch.assign(capacity / GRANULE_VERTICES, glm::vec4(origin, 0.0f));
+    glBindBuffer(GL_TEXTURE_BUFFER, pages[page].originBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(first / GRANULE_VERTICES) * sizeof(glm::vec4),
+                    originScratch.size() * sizeof(glm::vec4), originScratch.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    allocation.page = page;
+    allocation.first = first;
+    allocation.capacity = capacity;
+    return allocation;
+}
+
+void VertexArena::download(const Allocation& allocation, uint32_t count, std::vector<PackedChunkVertex>& vertices) const {
+    vertices.resize(allocation.valid() ? count : 0);
+    if (vertices.empty()) {
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, pages[allocation.page].vbo);
+    glGetBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(allocation.first) * sizeof(PackedChunkVertex),
+                       vertices.size() * sizeof(PackedChunkVertex), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VertexArena::release(Allocation& allocation) {
+    if (allocation.valid()) {
+        pages[allocation.page].ranges.free(allocation.first, allocation.capacity);
+    }
+    allocation = Allocation{};
+}
+
+void VertexArena::releaseAll() {
+    for (Page& page : pages) {
+        page.ranges.reset(page.ranges.getCapacity());
+    }
+}
+
+void VertexArena::destroy() {
+    for (Page& page : pages) {
+        if (page.vao) glDeleteVertexArrays(1, &page.vao);
+        if (page.vbo) glDeleteBuffers(1, &page.vbo);
+        if (page.originTexture) glDeleteTextures(1, &page.originTexture);
+        if (page.originBuffer) glDeleteBuffers(1, &page.originBuffer);
+    }
+    pages.clear();
+    if (indexBuffer) glDeleteBuffers(1, &indexBuffer);
+    indexBuffer = 0;
+    indexType = 0;
+    indexQuads = 0;
+}
+
+VertexArena::Stats VertexArena::getStats() const {
+    Stats stats;
+    stats.pages = static_cast<int>(pages.size());
+    for (const Page& page : pages) {
+        stats.capacityVertices += page.ranges.getCapacity();
+        stats.usedVertices += page.ranges.getUsed();
+        stats.freeRanges += page.ranges.freeRangeCount();
+    }
+    return stats;
+}
+
+int VertexArena::addPage(uint32_t vertices) {
+    Page page;
+    page.ranges.reset(vertices);
+    glGenVertexArrays(1, &page.vao);
+    glGenBuffers(1, &page.vbo);
+    glBindVertexArray(page.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, page.vbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices) * sizeof(PackedChunkVertex), nullptr, GL_DYNAMIC_DRAW);
+
+    // Integer attributes: chunk-local corner position, then face index + block type
+    glVertexAttribIPointer(0, 3, GL_UNSIGNED_SHORT, sizeof(PackedChunkVertex), (void*)offsetof(PackedChunkVertex, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 2, GL_UNSIGNED_BYTE, sizeof(PackedChunkVertex), (void*)offsetof(PackedChunkVertex, face));
+    glEnableVertexAttribArray(1);
+    // Element array binding is VAO state: every page draws through the shared quad indices
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &page.originBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, page.originBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(vertices / GRANULE_VERTICES) * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    glGenTextures(1, &page.originTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, page.originTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, page.originBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    pages.push_back(std::move(page));
+    return static_cast<int>(pages.size()) - 1;
+}
+
+void VertexArena::growQuadIndices(uint32_t quads) {
+    // Double so a run of slightly larger meshes doesn't rebuild the buffer each time, but stay on 16-bit
+    // indices for as long as the meshes themselves fit
+    uint32_t grown = std::max(quads, indexQuads * 2);
+    if (quads <= MAX_SHORT_INDEX_QUADS) {
+        grown = std::min(grown, MAX_SHORT_INDEX_QUADS);
+    }
+    if (!indexBuffer) {
+        glGenBuffers(1, &indexBuffer);
+    }
+    // The element array binding is VAO state, so re-specify the store with no VAO bound and the page VAOs keep the buffer
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    if (static_cast<uint64_t>(grown) * QUAD_VERTICES <= 65536) {
+        const std::vector<uint16_t> indices = quadIndices<uint16_t>(grown);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_SHORT;
+    } else {
+        const std::vector<uint32_t> indices = quadIndices<uint32_t>(grown);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_INT;
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    indexQuads = grown;
+}
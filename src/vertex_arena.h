@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+#include "range_allocator.h"
+
+// Chunk vertices for every loaded mesh, in a few large GL buffers ("pages") that live as long as the
+// renderer. Each mesh owns a range of one page; streaming a chunk in or out is a glBufferSubData or
+// a free-list update instead of creating and deleting buffers and VAOs. Every page has one VAO with
+// the PackedChunkVertex layout, so all meshes in a page draw from the same VAO with a base vertex and count
+// and can be submitted together with one multi-draw. A new page is only added when no existing page has
+// a large enough free range.
+//
+// Vertex positions are chunk-local, so each page also has a buffer texture with one world-space origin per
+// granule. Allocations start on a granule, so the vertex shader finds its chunk's origin at
+// texelFetch(chunkOrigins, gl_VertexID / GRANULE_VERTICES) without any per-draw uniform.
+//
+// Meshes are quads of QUAD_VERTICES vertices. Every page VAO has the same index buffer, the 0-1-2, 2-3-0
+// pattern repeated for as many quads as the largest mesh uploaded so far, so a mesh is drawn with its first
+// vertex as the base vertex (glDrawElementsBaseVertex and its multi-draw forms); gl_VertexID then includes
+// the base vertex, so the origin lookup above still works.
+class VertexArena {
+public:
+    // Vertices per page (8 bytes each): 16 MiB, enough for a greedy-meshed view in one page
+    static constexpr uint32_t PAGE_VERTICES = 1u << 21;
+    // Allocations are rounded up to this many vertices so freed ranges are reusable by similar meshes
+    static constexpr uint32_t GRANULE_VERTICES = 64;
+
+    struct Allocation {
+        int page = -1;
+        uint32_t first = 0;    // first vertex within the page
+        uint32_t capacity = 0; // vertices reserved (>= the mesh's vertex count)
+        bool valid() const { return page >= 0; }
+    };
+
+    struct Stats {
+        int pages = 0;
+        uint64_t capacityVertices = 0;
+        uint64_t usedVertices = 0;
+        size_t freeRanges = 0;
+    };
+
+    VertexArena() = default;
+    VertexArena(const VertexArena&) = delete;
+    VertexArena& operator=(const VertexArena&) = delete;
+
+    // Type of the shared quad indices, for the draw calls: GL_UNSIGNED_SHORT while every mesh uploaded so far
+    // has at most 65536 vertices, GL_UNSIGNED_INT after a larger one
+    unsigned int quadIndexType() const { return indexType; }
+
+    // Reserves space for `vertices`, grows the shared quad indices if this is the largest mesh so far, uploads them and records `origin` (world position of vertex (0, 0, 0))
+    // for the range; an invalid Allocation for an empty mesh
+    Allocation upload(const std::vector<PackedChunkVertex>& vertices, const glm::vec3& origin);
+    // Reads the first `count` vertices of the range back into `vertices` (a synchronous GPU read)
+    void download(const Allocation& allocation, uint32_t count, std::vector<PackedChunkVertex>& vertices) const;
+    void release(Allocation& allocation);
+    // Frees every range but keeps the pages (e.g. when all meshes are rebuilt)
+    void releaseAll();
+    // Deletes the GL buffers, VAOs and the index buffer; needs the context that created them
+    void destroy();
+
+    int pageCount() const { return static_cast<int>(pages.size()); }
+    unsigned int pageVao(int page) const { return pages[page].vao; }
+    // GL_TEXTURE_BUFFER texture (RGBA32F, one texel per granule) holding the page's chunk origins
+    unsigned int pageOriginTexture(int page) const { return pages[page].originTexture; }
+    Stats getStats() const;
+
+private:
+    struct Page {
+        unsigned int vao = 0;
+        unsigned int vbo = 0;
+        unsigned int originBuffer = 0;
+        unsigned int originTexture = 0;
+        RangeAllocator ranges;
+    };
+
+    int addPage(uint32_t vertices);
+    // Regenerates the index buffer's contents (the buffer name, bound in every page VAO, stays) to cover `quads`
+    void growQuadIndices(uint32_t quads);
+
+    std::vector<Page> pages;
+    unsigned int indexBuffer = 0;
+    unsigned int indexType = 0;
+    uint32_t indexQuads = 0; // quads covered by indexBuffer
+    std::vector<glm::vec4> originScratch;
+};